@@ -2,6 +2,7 @@
 #define APP_CONSTANTS_H
 
 #include <QColor>
+#include <cinttypes>
 
 /* Utility Functions */
 constexpr int CONVERT_TO_DEFAULT_STEP(const double value, const double min, const double max, const int steps) {
@@ -26,6 +27,7 @@ namespace UI_CONSTANTS {
     /* Timing */
     static constexpr int DEFAULT_TOAST_DURATION_MS = 3000;
     static constexpr int DEFAULT_FPS_SIZE = 16;
+    static constexpr int RESIZE_DEBOUNCE_MS = 120;
 
     /* others */
     static constexpr bool DEFAULT_USE_TEXTURE = false;
@@ -38,6 +40,7 @@ namespace BEZIER_CONSTANTS {
     static constexpr size_t BERNSTEIN_TABLE_SIZE = 4;
     static constexpr size_t CONTROL_POINTS_MATRIX_SIZE = 4;
     static constexpr int CONTROL_POINTS_DIM = 4;
+    static constexpr size_t CONTROL_NET_LINES_COUNT = 2 * CONTROL_POINTS_MATRIX_SIZE * (CONTROL_POINTS_MATRIX_SIZE - 1);
     static constexpr double DEFAULT_POINT_RADIUS = 15.0;
 }
 
@@ -53,15 +56,67 @@ namespace VIEW_SETTINGS {
 namespace LIGHTING_CONSTANTS {
     static constexpr float DEFAULT_KS = 0.5f;
     static constexpr float DEFAULT_KD = 0.5f;
+    /* ambient light is scaled by the baked occlusion of each vertex */
+    static constexpr float DEFAULT_KA = 0.2f;
     static constexpr int DEFAULT_M = 50;
+    /* Target interval between animation frames - movement itself depends on elapsed wall time */
     static constexpr int ANIMATION_TIME_STEP_MS = 33;
+    /* Spiral progress per second */
     static constexpr float LIGHT_SPEED = 0.1f;
-    static constexpr float LIGHT_MOVEMENT_STEP = (ANIMATION_TIME_STEP_MS / 1000.0) * LIGHT_SPEED;
     static constexpr Qt::GlobalColor DEFAULT_LIGHT_COLOR = Qt::white;
     static constexpr float NUMBER_OF_SPIRALS = 5.0f;
 
     static constexpr bool USE_REFLECTORS = false;
+
+    /* two lights reproduce the original light and its mirror */
+    static constexpr int DEFAULT_LIGHT_COUNT = 2;
+    static constexpr int MAX_LIGHT_COUNT = 64;
+
+    /* spot lights are culled from screen tiles where their cone term stays below this value */
+    static constexpr float LIGHT_CULL_THRESHOLD = 1.0f / 512.0f;
     static constexpr double DEFAULT_REFLECTION_COEF = 5.0;
+
+    /* Settled frames are lit per pixel, frames rendered during interaction per vertex of the full mesh */
+    static constexpr bool DEFAULT_PER_VERTEX_LIGHTING = false;
+    static constexpr bool DEFAULT_PER_VERTEX_PREVIEW = true;
+
+    /* Shadow maps - one per light, rebuilt after the mesh changes or once the light moves further than the threshold */
+    static constexpr bool DEFAULT_USE_SHADOWS = false;
+    static constexpr int32_t SHADOW_MAP_SIZE = 512;
+    static constexpr float SHADOW_MAP_LIGHT_THRESHOLD = 8.0f;
+    /* depth tolerance in map texels, removes self shadowing of lit surfaces */
+    static constexpr float SHADOW_BIAS_TEXELS = 2.0f;
+    /* PCF filter takes (2r + 1)^2 taps */
+    static constexpr int32_t SHADOW_PCF_RADIUS = 1;
+
+    /* Ambient occlusion bake - hemisphere rays per vertex, reaching this fraction of the mesh bounding box diagonal */
+    static constexpr int AO_RAY_COUNT = 32;
+    static constexpr float AO_DISTANCE_FRACTION = 0.25f;
+}
+
+namespace THREAD_CONSTANTS {
+    /* Threads of the shared pool including the caller, 0 - one per hardware thread */
+    static constexpr size_t DEFAULT_THREAD_COUNT = 0;
+    static constexpr size_t MAX_THREAD_COUNT = 64;
+
+    /* Failed attempts to take a task before a caller waiting for its loop goes to sleep */
+    static constexpr size_t CALLER_SPIN_COUNT = 64;
+
+    /* Thread count slider is applied once it rests, retried while background loops are running */
+    static constexpr int RESIZE_DEBOUNCE_MS = 250;
+
+    /* Screen rows owned by a single rasterization task - triangles crossing several bands are walked once per band */
+    static constexpr int32_t RASTER_BAND_HEIGHT = 16;
+}
+
+namespace RENDER_CONSTANTS {
+    /* Fast preview frame rendered immediately after user input */
+    static constexpr int PREVIEW_TRIANGLE_ACCURACY = 12;
+    static constexpr int PREVIEW_RESOLUTION_DIVIDER = 2;
+
+    /* Background refinement started after input stays idle */
+    static constexpr int REFINEMENT_IDLE_MS = 150;
+    static constexpr size_t REFINEMENT_TRIANGLES_PER_SLICE = 2048;
 }
 
 namespace SLIDER_CONSTANTS {
@@ -158,6 +213,18 @@ namespace SLIDER_CONSTANTS {
         );
     }
 
+    namespace KA {
+        static constexpr double MIN = 0.0;
+        static constexpr double MAX = 1.0;
+        static constexpr int STEPS = 100;
+        static constexpr int DEFAULT_STEP = CONVERT_TO_DEFAULT_STEP(
+            LIGHTING_CONSTANTS::DEFAULT_KA,
+            MIN,
+            MAX,
+            STEPS
+        );
+    }
+
     namespace M {
         static constexpr double MIN = 1.0;
         static constexpr double MAX = 100.0;
@@ -170,6 +237,30 @@ namespace SLIDER_CONSTANTS {
         );
     }
 
+    namespace LIGHT_COUNT {
+        static constexpr double MIN = 1.0;
+        static constexpr double MAX = LIGHTING_CONSTANTS::MAX_LIGHT_COUNT;
+        static constexpr int STEPS = LIGHTING_CONSTANTS::MAX_LIGHT_COUNT - 1;
+        static constexpr int DEFAULT_STEP = CONVERT_TO_DEFAULT_STEP(
+            LIGHTING_CONSTANTS::DEFAULT_LIGHT_COUNT,
+            MIN,
+            MAX,
+            STEPS
+        );
+    }
+
+    namespace THREAD_COUNT {
+        static constexpr double MIN = 0.0;
+        static constexpr double MAX = THREAD_CONSTANTS::MAX_THREAD_COUNT;
+        static constexpr int STEPS = THREAD_CONSTANTS::MAX_THREAD_COUNT;
+        static constexpr int DEFAULT_STEP = CONVERT_TO_DEFAULT_STEP(
+            THREAD_CONSTANTS::DEFAULT_THREAD_COUNT,
+            MIN,
+            MAX,
+            STEPS
+        );
+    }
+
     namespace LIGHT_POSITION {
         static constexpr double MIN = 100.0;
         static constexpr double MAX = 10000.0;
@@ -189,12 +280,44 @@ namespace RESOURCE_CONSTANTS {
     static constexpr const char *DEFAULT_TEXTURE_PATH = ":/data/test_texture.png";
     static constexpr const char *DEFAULT_NORMAL_MAP_PATH = ":/data/nmap1.png";
     static constexpr int TEXTURE_IMAGE_SIZE = 1000;
+
+    /* Processed textures cache - subdirectory of the platform cache location */
+    static constexpr const char *TEXTURE_CACHE_DIR = "textures";
+    /* Bump whenever texel processing or the file layout changes */
+    static constexpr uint32_t TEXTURE_CACHE_VERSION = 1;
+    /* Sources are keyed by path, size, modification time and this many bytes of both ends - smaller ones by the whole
+     * content */
+    static constexpr int64_t TEXTURE_CACHE_SAMPLE_BYTES = 4 << 20;
+
+    /* Images larger than this in any dimension are streamed as virtual textures instead of being resampled */
+    static constexpr int VIRTUAL_TEXTURE_THRESHOLD = 4096;
+    /* Tile edge in texels, must be power of two */
+    static constexpr int VIRTUAL_TEXTURE_TILE_SIZE = 256;
+    /* Resident tiles budget - 256 tiles of 258x258 texels take around 68 MB */
+    static constexpr size_t VIRTUAL_TEXTURE_MAX_TILES = 256;
+    static constexpr int VIRTUAL_TEXTURE_MAX_PENDING_LOADS = 8;
+
+    /* Largest decoded image accepted when resampling - formats that can not be streamed are decoded whole */
+    static constexpr int64_t MAX_DECODE_MEGABYTES = 2048;
+
+    /* Height map import - scales per texel gradient of heights in [0, 1], height maps rarely change by more than a few
+     * percent between neighbouring texels */
+    static constexpr double HEIGHT_MAP_DEFAULT_STRENGTH = 32.0;
+    static constexpr double HEIGHT_MAP_MIN_STRENGTH = 0.8;
+    static constexpr double HEIGHT_MAP_MAX_STRENGTH = 400.0;
 }
 
 /* Enums */
 enum class FillType {
     SIMPLE_COLOR,
-    TEXTURE
+    TEXTURE,
+    VIRTUAL_TEXTURE
+};
+
+/* Phong - lighting evaluated for every pixel, Gouraud - once per mesh vertex and interpolated over triangles */
+enum class ShadingModel {
+    PER_PIXEL,
+    PER_VERTEX
 };
 
 #endif /* APP_CONSTANTS_H */
@@ -28,6 +28,8 @@ public:
 
     [[nodiscard]] QVector3D get3DPoint() const { return m_point; }
 
+    void set3DPoint(const QVector3D &point) { m_point = point; }
+
     // ------------------------------
     // Class fields
     // ------------------------------
@@ -24,6 +24,7 @@
 
 /* Forward declaration */
 class StateMgr;
+class BezierPoint3DItem;
 
 class DrawingWidget : public QGraphicsView {
     Q_OBJECT
@@ -44,14 +45,17 @@ public:
     // Class interaction
     // ------------------------------
 
-    void drawBezierPoint(const QVector3D &point);
+    /* Overlay items are created once and only repositioned by these methods */
+    void setBezierPoint(size_t idx, const QVector3D &point);
 
-    void drawBezierLine(const QVector3D &start, const QVector3D &end);
+    void setBezierLine(size_t idx, const QVector3D &start, const QVector3D &end);
+
+    void setNetVisible(bool isVisible);
 
     [[nodiscard]] QPointF dropPointToScreen(const QVector3D &point) const;
 
-    [[nodiscard]] QPixmap *getPixMap() const {
-        return m_pixMap;
+    [[nodiscard]] QPixmap *getPixMap() {
+        return &m_pixMap;
     }
 
     // ------------------------------
@@ -60,8 +64,6 @@ public:
 public slots:
     void updateScene();
 
-    void clearContent();
-
     void setObserverDistance(double distance);
 
     void setPixmap(const QPixmap *pixmap) const;
@@ -85,11 +87,9 @@ protected:
 protected:
     void updateElements();
 
-    void _drawBezierPoint(const QVector3D &point, size_t idx) const;
+    void _onResizeSettled();
 
-    void _drawBezierLine(const std::pair<QVector3D, QVector3D> &line) const;
-
-    void _drawTriangleLine(const std::pair<QVector3D, QVector3D> &line) const;
+    void _createNetItems();
 
     // ------------------------------
     // Class fields
@@ -97,16 +97,19 @@ protected:
 
     QGraphicsScene *m_scene{};
     StateMgr *m_objectMgr{};
-    QPixmap *m_pixMap{};
+    QPixmap m_pixMap{};
     QGraphicsPixmapItem *m_pixMapItem{};
 
+    /* resize events are debounced - last frame is stretched until size settles */
+    QTimer *m_resizeTimer{};
+
     float m_width{};
     float m_height{};
 
     double m_observerDistance{};
 
-    std::vector<QVector3D> m_points{};
-    std::vector<std::pair<QVector3D, QVector3D> > m_lines{};
+    std::array<BezierPoint3DItem *, BEZIER_CONSTANTS::CONTROL_POINTS_COUNT> m_pointItems{};
+    std::array<QGraphicsLineItem *, BEZIER_CONSTANTS::CONTROL_NET_LINES_COUNT> m_lineItems{};
 };
 
 #endif //APP_DRAWINGWIDGET_H
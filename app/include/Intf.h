@@ -9,6 +9,7 @@
 #include "Constants.h"
 
 /* Collection of primitive data used in the project */
+#include "PrimitiveData/VectorMath.h"
 #include "PrimitiveData/ActiveEdge.h"
 #include "PrimitiveData/Vertex.h"
 #include "PrimitiveData/Triangle.h"
@@ -0,0 +1,108 @@
+//
+// Created by Jlisowskyy on 11/13/24.
+//
+
+#ifndef RESOURCELOADER_H
+#define RESOURCELOADER_H
+
+/* internal includes */
+#include "../Intf.h"
+#include "TextureCache.h"
+
+/* external includes */
+#include <QObject>
+#include <QImage>
+#include <QString>
+#include <QFutureWatcher>
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <memory>
+#include <vector>
+
+/* Forward Declarations */
+class TextureImage;
+class NormalMap;
+class VirtualTexture;
+
+/* Runs decoding, resampling and preprocessing of image resources on the global thread pool. Processed resources are
+ * kept in TextureCache so repeated loads are a page-in instead of decode. Only the latest request of each kind is
+ * delivered - older ones are cancelled between stages and their results dropped. */
+class ResourceLoader : public QObject {
+    Q_OBJECT
+
+    // ------------------------------
+    // Class inner types
+    // ------------------------------
+
+    enum class _ResourceKind {
+        TEXTURE,
+        NORMAL_MAP,
+        COUNT
+    };
+
+    // ------------------------------
+    // Class creation
+    // ------------------------------
+public:
+    explicit ResourceLoader(QObject *parent);
+
+    /* waits for running jobs, their results are dropped */
+    ~ResourceLoader() override;
+
+    // ------------------------------
+    // Class interaction
+    // ------------------------------
+
+    /* Large images are streamed as virtual textures when their format decodes clipped regions, otherwise resampled */
+    void loadTexture(const QString &path);
+
+    void loadNormalMap(const QString &path);
+
+    /* Generates normal map from a height image - delivered through normalMapLoaded, supersedes pending normal maps */
+    void loadHeightMap(const QString &path, float strength);
+
+    /* Synchronous decode used by the jobs - returns null image on failure */
+    [[nodiscard]] static QImage decodeScaledImage(const QByteArray &data);
+
+    // ------------------------------
+    // Class signals
+    // ------------------------------
+signals:
+    /* ownership of the resource is passed to the receiver */
+    void textureLoaded(TextureImage *image);
+
+    void normalMapLoaded(NormalMap *normalMap);
+
+    /* delivered instead of textureLoaded for images above VIRTUAL_TEXTURE_THRESHOLD */
+    void virtualTextureLoaded(VirtualTexture *texture);
+
+    void loadFailed(const QString &path);
+
+    // ------------------------------
+    // Class protected methods
+    // ------------------------------
+protected:
+    /* factory runs on the pool: (path, isCurrent) -> std::unique_ptr<ResourceT>, nullptr on failure */
+    template<typename ResourceT, typename FactoryT>
+    void _startJob(_ResourceKind kind, const QString &path, void (ResourceLoader::*signal)(ResourceT *),
+                   FactoryT factory);
+
+    /* decode, resample and preprocess - served from TextureCache when possible */
+    template<typename ResourceT, typename IsCurrentT>
+    [[nodiscard]] std::unique_ptr<ResourceT> _loadProcessed(const QString &path, const IsCurrentT &isCurrent) const;
+
+    [[nodiscard]] bool _isCurrent(_ResourceKind kind, uint64_t generation) const {
+        return m_generations[static_cast<size_t>(kind)].load(std::memory_order_relaxed) == generation;
+    }
+
+    // ------------------------------
+    // Class fields
+    // ------------------------------
+
+    TextureCache m_cache{};
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(_ResourceKind::COUNT)> m_generations{};
+    std::vector<QFutureWatcher<void> *> m_watchers{};
+};
+
+#endif //RESOURCELOADER_H
@@ -16,20 +16,45 @@
 #include <QGraphicsEllipseItem>
 
 #include "../GraphicObjects/DrawingWidget.h"
+#include "../Rendering/RenderTarget.h"
+#include "../Rendering/ShadingConstants.h"
+
+#include <memory>
+#include <vector>
+#include <chrono>
 
 
 /* Forward Declarations */
 class Mesh;
 class Texture;
+class TextureImage;
+class NormalMap;
+class VirtualTexture;
 class DrawingWidget;
 
 class SceneMgr final : public QObject {
     Q_OBJECT
 
     // ------------------------------
-    // Class creation
+    // Class inner types
     // ------------------------------
 public:
+    /* Single light of the scene - lights travel along the animation spiral */
+    struct LightDesc {
+        QColor color;
+        /* angle added to the animated position on the spiral, radians */
+        float phase;
+        /* height above the surface plane */
+        int z;
+        /* cone attenuation exponent used while reflectors are enabled */
+        float coneExponent;
+    };
+
+    // ------------------------------
+    // Class creation
+    // ------------------------------
+
+    /* lightCount lights of the same color, height and cone spread evenly around the spiral */
     explicit SceneMgr(QObject *parent,
                       const QColor &color,
                       bool drawNet,
@@ -37,7 +62,8 @@ public:
                       bool playAnimation,
                       const QColor &lightColor,
                       int lightZ,
-                      QImage *image = nullptr);
+                      int lightCount,
+                      float reflectorCoef);
 
     ~SceneMgr() override = default;
 
@@ -53,6 +79,14 @@ public:
 
     void unbound();
 
+    /* Marks current frame as outdated and drops running refinement - rendering is scheduled on the next event loop
+     * iteration */
+    void invalidate();
+
+    [[nodiscard]] const std::vector<LightDesc> &getLights() const {
+        return m_lights;
+    }
+
     // ------------------------------
     // Class public slots
     // ------------------------------
@@ -66,39 +100,139 @@ public slots:
 
     void setUseTexture(bool useTexture);
 
-    void setTextureImg(QImage *image);
+    void setTextureImg(TextureImage *image);
+
+    void setVirtualTexture(VirtualTexture *texture);
 
+    /* replaces every light of the scene - at least one, at most LIGHTING_CONSTANTS::MAX_LIGHT_COUNT */
+    void setLights(const std::vector<LightDesc> &lights);
+
+    /* setters below apply to all the lights */
     void setLightZ(int z);
 
+    /* ambient light takes the color as well */
     void setLightColor(const QColor &color);
 
-    void setNormalMap(QImage *image);
+    void setReflectorCoef(float reflectorCoef);
+
+    /* added lights copy the last one, phases are spread evenly again */
+    void setLightCount(int count);
+
+    void setNormalMap(NormalMap *image);
 
     void setUseNormals(bool useNormals);
 
+    void setShadingModel(ShadingModel model);
+
+    /* frames rendered during interaction use the full mesh lit per vertex instead of the coarse mesh lit per pixel */
+    void setUsePerVertexPreview(bool usePerVertexPreview);
+
+    // ------------------------------
+    // Class signals
+    // ------------------------------
+signals:
+    /* emitted after every frame pushed to the drawing widget, including preview and refinement passes */
+    void framePresented();
+
     // ------------------------------
     // Class protected methods
     // ------------------------------
 protected slots:
-    void _onTimer();
+    void _onFrame();
 
     void _onElementsUpdate(const DrawingWidget *sender);
 
+    void _onIdle();
+
+    void _onTilesArrived();
+
 protected:
+    /* Quality settings of a single rendered frame */
+    struct _RenderPassDesc {
+        bool usePreviewMesh;
+        int resolutionDivider;
+        bool allowNormals;
+        bool forcePerVertexLighting;
+        /* shadow maps are rebuilt with every rotation - interactive passes never pay for them */
+        bool allowShadows;
+    };
+
+    /* State of a frame which may be rasterized in several slices */
+    struct _RenderPass {
+        _RenderPassDesc desc{};
+        bool useNormals{};
+        ShadingModel shadingModel{};
+
+        const MeshArr *triangles{};
+        const MeshArr *figure{};
+
+        /* full passes point straight at the mesh arrays - any later change of the mesh makes the pass invalid */
+        uint64_t meshRevision{};
+
+        /* copies scaled down for lower resolution passes */
+        MeshArr scaledTriangles{};
+        MeshArr scaledFigure{};
+
+        RenderTarget *target{};
+
+        /* lights culled against the screen tiles of this pass and the rest of lighting settings */
+        ShadingConstants shading{};
+
+        size_t nextTriangle{};
+        std::chrono::nanoseconds renderTime{};
+    };
+
+    static constexpr _RenderPassDesc PREVIEW_PASS{
+        true, RENDER_CONSTANTS::PREVIEW_RESOLUTION_DIVIDER, false, false, false
+    };
+
+    /* lighting cost depends on the vertex count only - the full mesh stays affordable */
+    static constexpr _RenderPassDesc PER_VERTEX_PREVIEW_PASS{
+        false, RENDER_CONSTANTS::PREVIEW_RESOLUTION_DIVIDER, false, true, false
+    };
+
+    static constexpr _RenderPassDesc FULL_PASS{false, 1, true, false, true};
+
+    /* Passes executed in the background once user input stays idle */
+    static constexpr _RenderPassDesc REFINEMENT_PASSES[]{
+        {false, RENDER_CONSTANTS::PREVIEW_RESOLUTION_DIVIDER, true, false, true},
+        FULL_PASS,
+    };
+
     static void _drawNet(DrawingWidget &drawingWidget, const Mesh &mesh);
 
+    void _renderInteractive();
+
+    [[nodiscard]] const _RenderPassDesc &_getPreviewPass() const;
+
+    void _renderPass(const _RenderPassDesc &desc);
+
+    [[nodiscard]] std::unique_ptr<_RenderPass> _createPass(const _RenderPassDesc &desc);
+
+    void _drawPassSlice(_RenderPass &pass, size_t maxTriangles) const;
+
+    void _presentPass(_RenderPass &pass);
+
     template<bool drawNormals>
-    void _drawTexture(const DrawingWidget &drawingWidget, const Texture &texture, const Mesh &mesh);
+    void _drawTriangles(_RenderPass &pass, size_t begin, size_t end) const;
+
+    void _scheduleRefinementSlice();
+
+    void _abandonRefinement();
+
+    void _advanceAnimation(std::chrono::steady_clock::time_point now);
 
     void _processLightPosition();
 
-    [[nodiscard]] QPointF _getLightPosition2D() const;
+    [[nodiscard]] QPointF _getLightPosition2D(size_t idx) const;
 
-    [[nodiscard]] QVector3D _getLightPos() const;
+    [[nodiscard]] std::vector<LightSource> _getLightSources() const;
 
-    void _addLightItem(const DrawingWidget *drawingWidget);
+    /* evenly around the spiral - for two of them the second one mirrors the first */
+    void _spreadLightPhases();
 
-    void _drawTextureWithNormals(const DrawingWidget &drawingWidget, const Texture &texture, const Mesh &mesh);
+    /* keeps one light marker per light */
+    void _syncLightItems();
 
     // ------------------------------
     // Class fields
@@ -109,6 +243,10 @@ protected:
     bool m_isAnimationPlaying{};
     bool m_drawNet{};
     bool m_useNormals{};
+    ShadingModel m_shadingModel{
+        LIGHTING_CONSTANTS::DEFAULT_PER_VERTEX_LIGHTING ? ShadingModel::PER_VERTEX : ShadingModel::PER_PIXEL
+    };
+    bool m_usePerVertexPreview{LIGHTING_CONSTANTS::DEFAULT_PER_VERTEX_PREVIEW};
 
     /* connected objects */
     bool m_isBound{};
@@ -119,19 +257,30 @@ protected:
     /* Object state */
     FillType m_fillType;
 
-    /* color source for texture */
-    QImage *m_textureImg{};
+    /* color source for texture - at most one of them is set */
+    TextureImage *m_textureImg{};
+    VirtualTexture *m_virtualTexture{};
     QColor m_color{};
 
     /* light components */
-    QTimer *m_timer{};
-    int m_lightZ{};
+    QTimer *m_frameTimer{};
+    bool m_isFrameDirty{};
+    std::chrono::steady_clock::time_point m_lastAnimationStep{};
     float m_lightPos{};
+    std::vector<LightDesc> m_lights{};
+
+    /* progressive refinement */
+    QTimer *m_idleTimer{};
+    uint64_t m_renderGeneration{};
+    size_t m_refinementStage{};
+    std::unique_ptr<_RenderPass> m_refinementPass{};
+
+    /* passes never overlap - a single target is reused by all of them */
+    RenderTarget m_renderTarget{};
 
-    QGraphicsEllipseItem *m_lightEllipse{};
-    QGraphicsEllipseItem *m_lightEllipse1{};
+    std::vector<QGraphicsEllipseItem *> m_lightEllipses{};
 
-    QImage *m_normalMap{};
+    NormalMap *m_normalMap{};
 };
 
 #endif //SCENEMGR_H
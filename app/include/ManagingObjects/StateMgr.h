@@ -16,6 +16,8 @@
 #include <array>
 #include <QVector3D>
 #include <QFile>
+#include <QElapsedTimer>
+#include <QTimer>
 
 /* Forward declarations */
 class ToolBar;
@@ -28,6 +30,8 @@ class Texture;
 
 class SceneMgr;
 
+class ResourceLoader;
+
 class StateMgr : public QObject {
     Q_OBJECT
 
@@ -63,6 +67,8 @@ public slots:
 
     void onDeltaChanged(double value);
 
+    void onKAChanged(double value);
+
     void onKSChanged(double value);
 
     void onKDChanged(double value);
@@ -71,6 +77,10 @@ public slots:
 
     void onLightZChanged(double value);
 
+    void onLightCountChanged(double value);
+
+    void onThreadCountChanged(double value);
+
     void onReflectorCoefChanged(double value);
 
     /* toggle actions */
@@ -81,10 +91,16 @@ public slots:
 
     void onEnableNormalVectorsChanged(bool isChecked);
 
+    void onPerVertexLightingChanged(bool isChecked);
+
+    void onPerVertexPreviewChanged(bool isChecked);
+
     void onStopLightingMovementChanged(bool isChecked);
 
     void onUseReflectorChanged(bool isChecked);
 
+    void onUseShadowsChanged(bool isChecked);
+
     /* simple actions */
 
     void onLoadBezierPointsTriggered();
@@ -93,6 +109,8 @@ public slots:
 
     void onLoadNormalVectorsTriggered();
 
+    void onLoadHeightMapTriggered();
+
     void onColorChangedTriggered();
 
     void onLightColorChangedTriggered();
@@ -113,10 +131,16 @@ protected:
 
     void _loadNormalMap(const QString &path);
 
-    [[nodiscard]] QImage *_loadTextureFromFile(const QString &path);
+    void _loadHeightMap(const QString &path, float strength);
+
+    /* Startup timing - reports time to first presented frame */
+    void _onFramePresented();
 
     void _showToast(const QString &message, int duration = UI_CONSTANTS::DEFAULT_TOAST_DURATION_MS);
 
+    /* applies the settled thread count slider */
+    void _onThreadCountSettled();
+
     // ------------------------------
     // Class fields
     // ------------------------------
@@ -127,6 +151,14 @@ protected:
     Mesh *m_mesh{};
     Texture *m_texture{};
     SceneMgr *m_sceneMgr{};
+    ResourceLoader *m_resourceLoader{};
+
+    /* resizing joins and respawns the workers - done once the slider rests and no loop is running */
+    QTimer *m_threadCountTimer{};
+    size_t m_pendingThreadCount{};
+
+    QElapsedTimer m_startupTimer{};
+    QMetaObject::Connection m_firstFrameConnection{};
 };
 
 
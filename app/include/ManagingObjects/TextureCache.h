@@ -0,0 +1,118 @@
+//
+// Created by Jlisowskyy on 11/13/24.
+//
+
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+/* internal includes */
+#include "../Intf.h"
+
+/* external includes */
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <cinttypes>
+#include <cstddef>
+#include <memory>
+
+/* Forward Declarations */
+class TextureImage;
+class NormalMap;
+
+/* On-disk cache of fully processed texel storages keyed by a fingerprint of the source file. Entries are raw dumps of
+ * the in-memory representation and are mapped back without any decoding. All methods are safe to call from workers. */
+class TextureCache {
+    // ------------------------------
+    // Class inner types
+    // ------------------------------
+
+    enum class _EntryKind : uint32_t {
+        TEXTURE,
+        NORMAL_MAP
+    };
+
+    struct _FileHeader {
+        char magic[4];
+        uint32_t version;
+        _EntryKind kind;
+        uint32_t layout;
+        int32_t width;
+        int32_t height;
+        uint32_t levelCount;
+        uint32_t reserved;
+        uint64_t texelCount;
+    };
+
+    // ------------------------------
+    // Class creation
+    // ------------------------------
+public:
+    explicit TextureCache(const QString &directory = defaultDirectory());
+
+    ~TextureCache() = default;
+
+    // ------------------------------
+    // Class interaction
+    // ------------------------------
+
+    [[nodiscard]] static QString defaultDirectory();
+
+    /* fingerprint of the opened source combined with processing parameters - reads at most
+     * 2 * RESOURCE_CONSTANTS::TEXTURE_CACHE_SAMPLE_BYTES unless the whole content is needed, leaves the source
+     * positioned at its beginning */
+    [[nodiscard]] static QString makeKey(QFile &source);
+
+    /* returns nullptr when no valid entry exists */
+    template<typename ResourceT>
+    [[nodiscard]] ResourceT *load(const QString &key) const;
+
+    void store(const QString &key, const TextureImage &image) const;
+
+    void store(const QString &key, const NormalMap &normalMap) const;
+
+    // ------------------------------
+    // Class protected methods
+    // ------------------------------
+protected:
+    [[nodiscard]] QString _entryPath(const QString &key, _EntryKind kind) const;
+
+    /* maps the entry and validates its header, payload begins right after the header */
+    [[nodiscard]] std::unique_ptr<QFile> _mapEntry(const QString &key, _EntryKind kind, const _FileHeader **header,
+                                                   qint64 *size) const;
+
+    void _writeEntry(const QString &key, const _FileHeader &header, const QByteArray &payload) const;
+
+    /* payload does not match its header - logged, caller decodes the source again and overwrites the entry */
+    static std::nullptr_t _dropCorrupted(const QFile &file);
+
+    [[nodiscard]] static bool _isValidExtent(int32_t width, int32_t height);
+
+    /* levels of a full pyramid halving down to 1x1 */
+    [[nodiscard]] static uint32_t _getMipLevelCount(int32_t width, int32_t height);
+
+    [[nodiscard]] static _FileHeader _makeHeader(_EntryKind kind);
+
+    [[nodiscard]] static size_t _alignPayload(size_t offset) {
+        return (offset + PAYLOAD_ALIGNMENT - 1) & ~(PAYLOAD_ALIGNMENT - 1);
+    }
+
+    // ------------------------------
+    // Class fields
+    // ------------------------------
+
+    static constexpr size_t PAYLOAD_ALIGNMENT = 64;
+    /* keeps texel counts of hostile headers far from size_t overflow */
+    static constexpr int32_t MAX_EXTENT = 1 << 16;
+    static constexpr char MAGIC[4]{'G', 'K', 'T', 'C'};
+
+    QString m_directory{};
+};
+
+template<>
+TextureImage *TextureCache::load<TextureImage>(const QString &key) const;
+
+template<>
+NormalMap *TextureCache::load<NormalMap>(const QString &key) const;
+
+#endif //TEXTURECACHE_H
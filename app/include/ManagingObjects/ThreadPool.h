@@ -0,0 +1,190 @@
+//
+// Created by Jlisowskyy on 11/18/24.
+//
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+/* internal includes */
+#include "../Constants.h"
+
+/* external includes */
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/* Persistent worker threads, each with its own task deque. Loops are split lazily - a running chunk pushes its upper
+ * half to the deque of its thread until it fits the grain. Owners pop the newest halves, idle workers steal the
+ * oldest and therefore largest ones, so uneven iterations get balanced without any fixed schedule. The calling thread
+ * works on its own loop and returns once every iteration finished. */
+class ThreadPool {
+    // ------------------------------
+    // Class creation
+    // ------------------------------
+public:
+    /* threads including the caller, 0 - one per hardware thread */
+    explicit ThreadPool(size_t threadCount);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /* shared by the whole application, starts with THREAD_CONSTANTS::DEFAULT_THREAD_COUNT threads */
+    static ThreadPool &getInstance();
+
+    // ------------------------------
+    // Class interaction
+    // ------------------------------
+
+    /* waits for the running loops, must not be called from inside of one */
+    void resize(size_t threadCount);
+
+    /* resizes only if no loop is running at the moment - never blocks, returns false otherwise */
+    [[nodiscard]] bool tryResize(size_t threadCount);
+
+    [[nodiscard]] size_t getThreadCount() const {
+        return m_threadCount.load(std::memory_order_relaxed);
+    }
+
+    /* func(chunkBegin, chunkEnd) over [begin, end) in chunks of at most grainSize iterations - may be nested and
+     * called from any thread */
+    template<typename FuncT>
+    void parallelForChunks(size_t begin, size_t end, size_t grainSize, FuncT &&func);
+
+    /* func(idx) for every idx in [begin, end) */
+    template<typename FuncT>
+    void parallelFor(const size_t begin, const size_t end, const size_t grainSize, FuncT &&func) {
+        parallelForChunks(begin, end, grainSize, [&func](const size_t chunkBegin, const size_t chunkEnd) {
+            for (size_t idx = chunkBegin; idx < chunkEnd; ++idx) {
+                func(idx);
+            }
+        });
+    }
+
+    // ------------------------------
+    // Class protected methods
+    // ------------------------------
+protected:
+    struct _Job {
+        void (*invoke)(void *context, size_t begin, size_t end);
+        void *context;
+        size_t grainSize;
+
+        /* iterations not finished yet - the job lives on the stack of its caller until this drops to 0 */
+        std::atomic<size_t> remaining;
+    };
+
+    struct _Task {
+        _Job *job;
+        size_t begin;
+        size_t end;
+    };
+
+    struct _TaskDeque {
+        std::mutex mutex{};
+        std::deque<_Task> tasks{};
+    };
+
+    template<typename FuncT>
+    static void _invokeChunk(void *context, const size_t begin, const size_t end) {
+        (*static_cast<FuncT *>(context))(begin, end);
+    }
+
+    /* executes tasks of the job until it is finished, sleeps once there is nothing left to take */
+    void _runJob(_Job &job, size_t begin, size_t end);
+
+    void _execute(_Task task);
+
+    void _push(const _Task &task);
+
+    /* newest task of the own deque first, then the oldest one of any other deque - only tasks of the given job
+     * unless it is nullptr */
+    [[nodiscard]] bool _tryPop(_Task &task, const _Job *job);
+
+    void _workerLoop(size_t dequeIdx);
+
+    void _start(size_t threadCount);
+
+    void _stop();
+
+    // ------------------------------
+    // Class fields
+    // ------------------------------
+
+    /* deque of the current thread inside the pool it belongs to */
+    static thread_local ThreadPool *s_workerPool;
+    static thread_local size_t s_dequeIdx;
+
+    /* loops the current thread is inside of - only the outermost one holds m_resizeMutex */
+    static thread_local size_t s_loopDepth;
+
+    std::atomic<size_t> m_threadCount{};
+
+    /* deque 0 is shared by every thread outside of the pool, workers own the rest */
+    std::vector<std::unique_ptr<_TaskDeque> > m_deques{};
+    std::vector<std::thread> m_workers{};
+
+    /* tasks sitting in the deques - updated under the deque locks */
+    std::atomic<size_t> m_queuedTasks{};
+    std::atomic<size_t> m_sleepingWorkers{};
+
+    /* bumped after every finished task - callers waiting for their jobs sleep on it */
+    std::atomic<uint32_t> m_finishedTasks{};
+    std::atomic<size_t> m_waitingCallers{};
+
+    std::mutex m_sleepMutex{};
+    std::condition_variable m_sleepCondition{};
+    bool m_isStopping{};
+
+    /* held shared by the running outermost loops, exclusively by resize */
+    std::shared_mutex m_resizeMutex{};
+};
+
+template<typename FuncT>
+void ThreadPool::parallelForChunks(const size_t begin, const size_t end, const size_t grainSize, FuncT &&func) {
+    if (begin >= end) {
+        return;
+    }
+
+    const size_t grain = std::max<size_t>(grainSize, 1);
+
+    std::shared_lock lock(m_resizeMutex, std::defer_lock);
+    if (s_loopDepth == 0) {
+        lock.lock();
+    }
+
+    ++s_loopDepth;
+
+    if (m_workers.empty() || end - begin <= grain) {
+        /* no one to share the work with */
+        for (size_t chunkBegin = begin; chunkBegin < end;) {
+            const size_t chunkEnd = chunkBegin + std::min(grain, end - chunkBegin);
+            func(chunkBegin, chunkEnd);
+            chunkBegin = chunkEnd;
+        }
+    } else {
+        _Job job{
+            &_invokeChunk<std::remove_reference_t<FuncT> >,
+            const_cast<void *>(static_cast<const void *>(std::addressof(func))),
+            grain,
+            end - begin
+        };
+
+        _runJob(job, begin, end);
+    }
+
+    --s_loopDepth;
+}
+
+#endif //THREADPOOL_H
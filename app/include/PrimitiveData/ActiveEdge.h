@@ -5,9 +5,12 @@
 #ifndef ACTIVEEDGE_H
 #define ACTIVEEDGE_H
 
+/* internal includes */
+#include "VectorMath.h"
+
 /* External includes */
-#include <QVector3D>
 #include <cmath>
+#include <limits>
 
 struct ActiveEdge {
     int yMax{};
@@ -16,15 +19,15 @@ struct ActiveEdge {
     float dx{};
     float dz{};
 
-    ActiveEdge(const QVector3D &upper, const QVector3D &lower) {
-        yMax = static_cast<int>(std::floor(upper.y()));
-        x = lower.x();
-        z = lower.z();
+    ActiveEdge(const float3 &upper, const float3 &lower) {
+        yMax = static_cast<int>(std::floor(upper.y));
+        x = lower.x;
+        z = lower.z;
 
-        const float dy = upper.y() - lower.y();
+        const float dy = upper.y - lower.y;
         if (std::abs(dy) > std::numeric_limits<float>::epsilon()) {
-            dx = (upper.x() - lower.x()) / dy;
-            dz = (upper.z() - lower.z()) / dy;
+            dx = (upper.x - lower.x) / dy;
+            dz = (upper.z - lower.z) / dy;
         } else {
             dx = 0.0f;
             dz = 0.0f;
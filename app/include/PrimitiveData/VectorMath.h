@@ -0,0 +1,163 @@
+//
+// Created by Jlisowskyy on 11/17/24.
+//
+
+#ifndef VECTORMATH_H
+#define VECTORMATH_H
+
+/* external includes */
+#include <QVector3D>
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+
+#ifdef __SSE__
+#include <immintrin.h>
+#endif
+
+/* Plain float vectors used by the rasterizer and shading kernels. Unlike QVector3D there is no double precision
+ * hypot nor fuzzy zero checks behind length and normalization. QVector3D is converted from and to only at the Qt
+ * boundary - control points, widgets and settings. */
+
+/* a * b + c, fused when the target has FMA instructions */
+[[nodiscard]] inline float fmadd(const float a, const float b, const float c) {
+#ifdef __FMA__
+    return std::fma(a, b, c);
+#else
+    return a * b + c;
+#endif
+}
+
+/* 1 / sqrt(x) for x > 0 - hardware estimate refined by one Newton step, relative error below 1e-6 */
+[[nodiscard]] inline float rsqrt(const float x) {
+#ifdef __SSE__
+    const float estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    return estimate * (1.5f - 0.5f * x * estimate * estimate);
+#else
+    return 1.0f / std::sqrt(x);
+#endif
+}
+
+struct float3 {
+    float x{};
+    float y{};
+    float z{};
+
+    constexpr float3() = default;
+
+    constexpr float3(const float x, const float y, const float z) : x(x), y(y), z(z) {
+    }
+
+    explicit float3(const QVector3D &v) : x(v.x()), y(v.y()), z(v.z()) {
+    }
+
+    [[nodiscard]] QVector3D toQt() const {
+        return {x, y, z};
+    }
+
+    [[nodiscard]] float operator[](const int axis) const {
+        return axis == 0 ? x : axis == 1 ? y : z;
+    }
+
+    float3 &operator+=(const float3 &v) {
+        x += v.x;
+        y += v.y;
+        z += v.z;
+        return *this;
+    }
+
+    float3 &operator-=(const float3 &v) {
+        x -= v.x;
+        y -= v.y;
+        z -= v.z;
+        return *this;
+    }
+
+    float3 &operator*=(const float s) {
+        x *= s;
+        y *= s;
+        z *= s;
+        return *this;
+    }
+};
+
+[[nodiscard]] inline float3 operator+(float3 a, const float3 &b) { return a += b; }
+[[nodiscard]] inline float3 operator-(float3 a, const float3 &b) { return a -= b; }
+[[nodiscard]] inline float3 operator-(const float3 &a) { return {-a.x, -a.y, -a.z}; }
+[[nodiscard]] inline float3 operator*(float3 a, const float s) { return a *= s; }
+[[nodiscard]] inline float3 operator*(const float s, float3 a) { return a *= s; }
+[[nodiscard]] inline float3 operator/(const float3 &a, const float s) { return a * (1.0f / s); }
+
+/* component-wise */
+[[nodiscard]] inline float3 operator*(const float3 &a, const float3 &b) { return {a.x * b.x, a.y * b.y, a.z * b.z}; }
+
+[[nodiscard]] inline float dot(const float3 &a, const float3 &b) {
+    return fmadd(a.x, b.x, fmadd(a.y, b.y, a.z * b.z));
+}
+
+[[nodiscard]] inline float3 cross(const float3 &a, const float3 &b) {
+    return {
+        fmadd(a.y, b.z, -a.z * b.y),
+        fmadd(a.z, b.x, -a.x * b.z),
+        fmadd(a.x, b.y, -a.y * b.x)
+    };
+}
+
+/* a * s + b */
+[[nodiscard]] inline float3 fmadd(const float3 &a, const float s, const float3 &b) {
+    return {fmadd(a.x, s, b.x), fmadd(a.y, s, b.y), fmadd(a.z, s, b.z)};
+}
+
+[[nodiscard]] inline float lengthSquared(const float3 &v) { return dot(v, v); }
+[[nodiscard]] inline float length(const float3 &v) { return std::sqrt(dot(v, v)); }
+
+/* zero vector stays zero */
+[[nodiscard]] inline float3 normalize(const float3 &v) {
+    return v * rsqrt(std::max(dot(v, v), FLT_MIN));
+}
+
+[[nodiscard]] inline float3 min(const float3 &a, const float3 &b) {
+    return {std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z)};
+}
+
+[[nodiscard]] inline float3 max(const float3 &a, const float3 &b) {
+    return {std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z)};
+}
+
+/* Structure of arrays holding N vectors - normalizeBatch runs one lane per vector */
+template<size_t N>
+struct float3Batch {
+    alignas(32) std::array<float, N> x{};
+    alignas(32) std::array<float, N> y{};
+    alignas(32) std::array<float, N> z{};
+
+    void set(const size_t idx, const float3 &v) {
+        x[idx] = v.x;
+        y[idx] = v.y;
+        z[idx] = v.z;
+    }
+
+    [[nodiscard]] float3 get(const size_t idx) const {
+        return {x[idx], y[idx], z[idx]};
+    }
+};
+
+/* first count vectors only */
+template<size_t N>
+void normalizeBatch(float3Batch<N> &batch, const size_t count) {
+#pragma omp simd
+    for (size_t i = 0; i < count; ++i) {
+        const float lengthSq = std::max(batch.x[i] * batch.x[i] + batch.y[i] * batch.y[i] + batch.z[i] * batch.z[i],
+                                        FLT_MIN);
+        /* plain division - vectorizes to the packed square root */
+        const float invLength = 1.0f / std::sqrt(lengthSq);
+
+        batch.x[i] *= invLength;
+        batch.y[i] *= invLength;
+        batch.z[i] *= invLength;
+    }
+}
+
+#endif //VECTORMATH_H
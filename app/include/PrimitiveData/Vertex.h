@@ -5,29 +5,36 @@
 #ifndef APP_VERTEX_H
 #define APP_VERTEX_H
 
+/* internal includes */
+#include "VectorMath.h"
+
 /* external includes */
-#include <QVector3D>
+#include <cinttypes>
 
 struct Vertex {
-    /* before rotations */
-    QVector3D position{};
-    QVector3D puVector{};
-    QVector3D pvVector{};
-    QVector3D normal{};
-
-    /* after rotations */
-    QVector3D rotatedPosition{};
-    QVector3D rotatedPuVector{};
-    QVector3D rotatedPvVector{};
-    QVector3D rotatedNormal{};
+    /* before rotations - tangent, bitangent and normal form an orthonormal frame, tangent follows the u direction */
+    float3 position{};
+    float3 tangent{};
+    float3 bitangent{};
+    float3 normal{};
+
+    /* after rotations - the tangent frame is only used in object space by the normal map bake and AO rays */
+    float3 rotatedPosition{};
+    float3 rotatedNormal{};
 
     /* base space coordinates */
     float u{};
     float v{};
 
+    /* same for every copy of the surface point - triangles meeting at it hold their own copies */
+    uint32_t index{};
+
+    /* fraction of the hemisphere above the point not blocked by the surface itself, baked with tessellation */
+    float ao{1.0f};
+
     Vertex() = default;
 
-    Vertex(const QVector3D &p, const QVector3D &pu, const QVector3D &pv, const QVector3D &n, float u, float v,
+    Vertex(const float3 &p, const float3 &t, const float3 &b, const float3 &n, float u, float v,
            float alpha, float beta, float delta);
 
     void resetRotation();
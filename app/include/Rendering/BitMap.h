@@ -27,6 +27,9 @@ public:
     // Class interaction
     // ------------------------------
 
+    /* Changes logical size - memory is reallocated only when current capacity is exceeded */
+    void resize(int32_t width, int32_t height);
+
     void setWhiteAll();
 
     [[nodiscard]] QColor colorAt(const int32_t x, const int32_t y) const {
@@ -60,6 +63,10 @@ public:
         setColorAt(x, y, color.red(), color.green(), color.blue());
     }
 
+    void setRgbAt(const int32_t x, const int32_t y, const QRgb color) {
+        setColorAt(x, y, qRed(color), qGreen(color), qBlue(color));
+    }
+
     void dropToPixMap(QPixmap &pixMap) const;
 
     [[nodiscard]] int32_t width() const {
@@ -90,6 +97,7 @@ protected:
 
     int32_t m_width{};
     int32_t m_height{};
+    size_t m_capacity{};
 };
 
 
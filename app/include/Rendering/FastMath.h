@@ -0,0 +1,57 @@
+//
+// Created by Jlisowskyy on 11/15/24.
+//
+
+#ifndef FASTMATH_H
+#define FASTMATH_H
+
+/* external includes */
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+#include <cmath>
+
+/* Branch free approximations of transcendental functions - plain arithmetic only, so loops calling them still get
+ * vectorized, unlike loops calling std::pow */
+namespace FastMath {
+    /* x > 0, absolute error below 1e-7 */
+    [[nodiscard]] inline float log2(const float x) {
+        const auto bits = std::bit_cast<uint32_t>(x);
+        float exponent = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+        float mantissa = std::bit_cast<float>((bits & 0x7FFFFFu) | 0x3F800000u);
+
+        /* mantissa in [sqrt(2) / 2, sqrt(2)) keeps the series argument small */
+        const bool isAboveSqrt2 = mantissa > 1.41421356f;
+        mantissa = isAboveSqrt2 ? 0.5f * mantissa : mantissa;
+        exponent = isAboveSqrt2 ? exponent + 1.0f : exponent;
+
+        /* ln(m) = 2 atanh((m - 1) / (m + 1)), |s| < 0.172 */
+        const float s = (mantissa - 1.0f) / (mantissa + 1.0f);
+        const float s2 = s * s;
+        const float ln = 2.0f * s * (1.0f + s2 * (1.0f / 3.0f + s2 * (1.0f / 5.0f + s2 * (1.0f / 7.0f))));
+
+        return exponent + ln * 1.44269504f;
+    }
+
+    /* relative error below 2e-7, results below 2^-126 are flushed to 2^-126 */
+    [[nodiscard]] inline float exp2(float y) {
+        y = std::clamp(y, -126.0f, 127.0f);
+
+        const float n = std::floor(y + 0.5f);
+        const float g = (y - n) * 0.69314718f;
+
+        /* e^g for |g| <= ln(2) / 2 */
+        const float p = 1.0f + g * (1.0f + g * (1.0f / 2.0f + g * (1.0f / 6.0f + g * (1.0f / 24.0f +
+                                                          g * (1.0f / 120.0f + g * (1.0f / 720.0f))))));
+
+        return std::bit_cast<float>(std::bit_cast<int32_t>(p) + (static_cast<int32_t>(n) << 23));
+    }
+
+    /* x^exponent for x in [0, 1], 0 for x <= 0. Absolute error stays below 1e-6 for exponents up to 100 - far below
+     * 8 bit color precision */
+    [[nodiscard]] inline float pow01(const float x, const float exponent) {
+        return x > 0.0f ? exp2(exponent * log2(x)) : 0.0f;
+    }
+}
+
+#endif //FASTMATH_H
@@ -0,0 +1,80 @@
+//
+// Created by Jlisowskyy on 11/14/24.
+//
+
+#ifndef LIGHTGRID_H
+#define LIGHTGRID_H
+
+/* internal includes */
+#include "../Intf.h"
+#include "LightSet.h"
+
+/* external includes */
+#include <cinttypes>
+#include <vector>
+
+/* Screen split into square tiles, each with the lights that can reach it. Built once per render pass from the tile
+ * bounds - screen rectangle and depth range of the triangles overlapping it. Lights are unattenuated, so only spot
+ * lights get culled: whenever their cone term stays below LIGHT_CULL_THRESHOLD over the whole tile. */
+class LightGrid {
+    // ------------------------------
+    // Class creation
+    // ------------------------------
+public:
+    static constexpr int32_t TILE_SHIFT = 5;
+    static constexpr int32_t TILE_SIZE = 1 << TILE_SHIFT;
+
+    LightGrid() = default;
+
+    ~LightGrid() = default;
+
+    LightGrid(const LightGrid &) = delete;
+
+    LightGrid &operator=(const LightGrid &) = delete;
+
+    // ------------------------------
+    // Class interaction
+    // ------------------------------
+
+    /* triangles and lights in the centered coordinates used by the rasterizer */
+    void build(const LightSet &lights, const MeshArr &triangles, int32_t width, int32_t height);
+
+    [[nodiscard]] const LightSet &lightsAt(const int32_t screenX, const int32_t screenY) const {
+        return m_tileSets[m_tileSetIdx[(screenY >> TILE_SHIFT) * m_tilesX + (screenX >> TILE_SHIFT)]];
+    }
+
+    /* all the lights of the pass */
+    [[nodiscard]] const LightSet &lights() const {
+        return m_tileSets.front();
+    }
+
+    // ------------------------------
+    // Class protected methods
+    // ------------------------------
+protected:
+    struct _TileBounds {
+        float minZ;
+        float maxZ;
+    };
+
+    void _computeTileDepths(const MeshArr &triangles, int32_t width, int32_t height);
+
+    /* cone against bounding sphere of the tile box */
+    [[nodiscard]] static bool _isConeTouchingSphere(const float3 &apex, const float3 &axis, float cosAngle,
+                                                    const float3 &center, float radius);
+
+    // ------------------------------
+    // Class fields
+    // ------------------------------
+
+    int32_t m_tilesX{};
+    int32_t m_tilesY{};
+
+    std::vector<_TileBounds> m_tileBounds{};
+
+    /* first set holds all the lights, tiles with the same surviving lights share a set */
+    std::vector<LightSet> m_tileSets{};
+    std::vector<uint32_t> m_tileSetIdx{};
+};
+
+#endif //LIGHTGRID_H
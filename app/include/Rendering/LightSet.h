@@ -0,0 +1,116 @@
+//
+// Created by Jlisowskyy on 11/14/24.
+//
+
+#ifndef LIGHTSET_H
+#define LIGHTSET_H
+
+/* internal includes */
+#include "../PrimitiveData/VectorMath.h"
+
+/* external includes */
+#include <cinttypes>
+#include <vector>
+
+/* Forward Declarations */
+class ShadowMap;
+
+/* Light as given by the scene - world space position, color channels in [0, 1], cone exponent applied while
+ * reflectors are enabled */
+struct LightSource {
+    float3 position;
+    float3 color;
+    float coneExponent;
+};
+
+/* Point and spot lights of a single frame. Every attribute is kept in its own array so shading evaluates all the
+ * lights of a pixel in one vectorized loop - cost grows linearly with the light count. */
+class LightSet {
+    // ------------------------------
+    // Class inner types
+    // ------------------------------
+public:
+    struct Light {
+        float3 position;
+
+        /* light color premultiplied by the material coefficients, channels in [0, 1] */
+        float3 diffuse;
+        float3 specular;
+
+        /* unit cone axis pointing from the light into the scene - attenuation is max(0, cos)^coneExponent,
+         * 0 turns the light into a point light */
+        float3 direction;
+        float coneExponent;
+
+        /* null when the light casts no shadows */
+        const ShadowMap *shadowMap;
+    };
+
+    // ------------------------------
+    // Class creation
+    // ------------------------------
+
+    LightSet() = default;
+
+    ~LightSet() = default;
+
+    // ------------------------------
+    // Class interaction
+    // ------------------------------
+
+    void addLight(const Light &light);
+
+    void clear();
+
+    [[nodiscard]] size_t size() const {
+        return m_posX.size();
+    }
+
+    [[nodiscard]] Light lightAt(size_t idx) const;
+
+    [[nodiscard]] const float *posX() const { return m_posX.data(); }
+    [[nodiscard]] const float *posY() const { return m_posY.data(); }
+    [[nodiscard]] const float *posZ() const { return m_posZ.data(); }
+
+    [[nodiscard]] const float *diffuseR() const { return m_diffuseR.data(); }
+    [[nodiscard]] const float *diffuseG() const { return m_diffuseG.data(); }
+    [[nodiscard]] const float *diffuseB() const { return m_diffuseB.data(); }
+
+    [[nodiscard]] const float *specularR() const { return m_specularR.data(); }
+    [[nodiscard]] const float *specularG() const { return m_specularG.data(); }
+    [[nodiscard]] const float *specularB() const { return m_specularB.data(); }
+
+    [[nodiscard]] const float *dirX() const { return m_dirX.data(); }
+    [[nodiscard]] const float *dirY() const { return m_dirY.data(); }
+    [[nodiscard]] const float *dirZ() const { return m_dirZ.data(); }
+
+    [[nodiscard]] const float *coneExponent() const { return m_coneExponent.data(); }
+
+    [[nodiscard]] const ShadowMap *const *shadowMap() const { return m_shadowMap.data(); }
+
+    // ------------------------------
+    // Class fields
+    // ------------------------------
+protected:
+    std::vector<float> m_posX{};
+    std::vector<float> m_posY{};
+    std::vector<float> m_posZ{};
+
+    std::vector<float> m_diffuseR{};
+    std::vector<float> m_diffuseG{};
+    std::vector<float> m_diffuseB{};
+
+    std::vector<float> m_specularR{};
+    std::vector<float> m_specularG{};
+    std::vector<float> m_specularB{};
+
+    std::vector<float> m_dirX{};
+    std::vector<float> m_dirY{};
+    std::vector<float> m_dirZ{};
+
+    std::vector<float> m_coneExponent{};
+
+    std::vector<const ShadowMap *> m_shadowMap{};
+};
+
+#endif //LIGHTSET_H
@@ -12,6 +12,8 @@
 /* external includes */
 #include <QObject>
 #include <Qt>
+#include <array>
+#include <tuple>
 
 class Mesh : public QObject {
     Q_OBJECT
@@ -36,12 +38,35 @@ public:
         return m_triangles;
     }
 
+    /* Coarse tessellation of the same surface used for fast interactive preview frames */
+    [[nodiscard]] const MeshArr &getPreviewMeshArr() const {
+        return m_previewTriangles;
+    }
+
     [[nodiscard]] const MeshArr &getFigure() const {
         return m_figure;
     }
 
+    /* Changes whenever triangles of getMeshArr() move - tessellation, control points or rotation */
+    [[nodiscard]] uint64_t getRevision() const {
+        return m_revision;
+    }
+
+    static void rotate(float3 &p, float xRotationAngle, float zRotationAngle, float yRotationAngle);
+
     static void rotate(QVector3D &p, float xRotationAngle, float zRotationAngle, float yRotationAngle);
 
+    /* Columns of the current rotation - rotate() is linear so any vector maps to b0 * x + b1 * y + b2 * z */
+    [[nodiscard]] std::array<float3, 3> getRotationBasis() const;
+
+    /* Surface point with its partial derivatives at (u, v) */
+    [[nodiscard]] static std::tuple<float3, float3, float3> evaluateSurface(
+        const ControlPoints &controlPoints, float u, float v);
+
+    /* Orthonormal tangent, bitangent and normal from the partial derivatives - tangent follows pu, bitangent is the
+     * part of pv perpendicular to it. Zero derivatives give zero frame. */
+    [[nodiscard]] static std::tuple<float3, float3, float3> computeTangentFrame(const float3 &pu, const float3 &pv);
+
     void alignWithMeshPlain(QVector3D &p) const { rotate(p, m_alpha, m_beta, m_delta); }
 
     [[nodiscard]] QVector3D getPointAlignedWithMeshPlain(const QVector3D &p) const {
@@ -52,7 +77,7 @@ public:
 
     void setControlPoints(const ControlPoints &controlPoints);
 
-    void rotateFigure();
+    void rotateFigure(float elapsedSeconds);
 
     QColor getFigureColor(size_t idx) const;
 
@@ -72,12 +97,17 @@ public slots:
     // Class protected methods
     // ------------------------------
 protected:
-    [[nodiscard]] MeshArr _interpolateBezier(const ControlPoints &controlPoints) const;
+    [[nodiscard]] MeshArr _interpolateBezier(const ControlPoints &controlPoints, int accuracy) const;
+
+    /* ambient occlusion of every unique vertex - object space, so rotations keep it valid */
+    static void _bakeAmbientOcclusion(MeshArr &triangles);
+
+    [[nodiscard]] int _getPreviewAccuracy() const;
 
     [[nodiscard]] static std::tuple<BernsteinTable, BernsteinTable> _computeBernstein(float t);
 
-    [[nodiscard]] static std::tuple<QVector3D, QVector3D, QVector3D> _computePointAndDeriv(
-        const ControlPoints &points,
+    [[nodiscard]] static std::tuple<float3, float3, float3> _computePointAndDeriv(
+        const ControlPoints &controlPoints,
         const BernsteinTable &bu,
         const BernsteinTable &bv,
         const BernsteinTable &buDeriv,
@@ -91,6 +121,10 @@ protected:
     // Class fields
     // ------------------------------
 
+    /* thread pool grains */
+    static constexpr size_t TRIANGLES_PER_TASK = 256;
+    static constexpr size_t AO_VERTICES_PER_TASK = 64;
+
     int m_triangleAccuracy;
     float m_alpha;
     float m_beta;
@@ -98,7 +132,10 @@ protected:
 
     ControlPoints m_controlPoints;
     MeshArr m_triangles;
+    MeshArr m_previewTriangles;
     MeshArr m_figure;
+
+    uint64_t m_revision{};
 };
 
 #endif //MESH_H
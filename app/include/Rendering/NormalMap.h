@@ -0,0 +1,152 @@
+//
+// Created by Jlisowskyy on 11/13/24.
+//
+
+#ifndef NORMALMAP_H
+#define NORMALMAP_H
+
+/* internal includes */
+#include "../Intf.h"
+#include "TexelLayout.h"
+
+/* external includes */
+#include <QImage>
+#include <QFile>
+#include <memory>
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <vector>
+
+/* Normal map decoded and normalized once at load time, stored as octahedral int16 pairs (4 bytes per texel) */
+class NormalMap {
+    // ------------------------------
+    // Class inner types
+    // ------------------------------
+public:
+    struct PackedNormal {
+        int16_t x;
+        int16_t y;
+    };
+
+    // ------------------------------
+    // Class creation
+    // ------------------------------
+
+    /* decodes tangent space normals from rgb channels: (c - 127) / 127 */
+    explicit NormalMap(const QImage &image, TexelLayout layout = TexelLayout::TILED_4X4);
+
+    ~NormalMap() = default;
+
+    NormalMap(const NormalMap &) = delete;
+
+    NormalMap &operator=(const NormalMap &) = delete;
+
+    /* Resolves tangent space map against the surface described by controlPoints - result holds object space normals,
+     * which only need the mesh rotation applied per pixel */
+    [[nodiscard]] static NormalMap *bakeObjectSpace(const NormalMap &tangentMap, const ControlPoints &controlPoints);
+
+    /* Tangent space normals from a height image (luminance, white is high) through 3x3 Sobel filter - strength scales
+     * the per texel gradient of heights taken in [0, 1] */
+    [[nodiscard]] static NormalMap *fromHeightMap(const QImage &heightImage, float strength,
+                                                  TexelLayout layout = TexelLayout::TILED_4X4);
+
+    // ------------------------------
+    // Class interaction
+    // ------------------------------
+
+    [[nodiscard]] int32_t width() const {
+        return m_width;
+    }
+
+    [[nodiscard]] int32_t height() const {
+        return m_height;
+    }
+
+    /* (u, v) in [0, 1] mapped the same way as in TextureImage, returns unit vector */
+    [[nodiscard]] float3 sampleNearest(const float u, const float v) const {
+        const auto x = static_cast<int32_t>(TexelAddressing::clampCoord(v * m_xScale, m_xScale));
+        const auto y = static_cast<int32_t>(TexelAddressing::clampCoord((1.0f - u) * m_yScale, m_yScale));
+
+        return decode(_texelAt(x, y));
+    }
+
+    [[nodiscard]] static PackedNormal encode(const float3 &normal);
+
+    [[nodiscard]] static float3 decode(PackedNormal packed);
+
+    // ------------------------------
+    // Class protected methods
+    // ------------------------------
+protected:
+    friend class TextureCache;
+
+    /* storage is filled by TextureCache */
+    NormalMap() = default;
+
+    /* allocates storage only, texels are left zeroed */
+    NormalMap(int32_t width, int32_t height, TexelLayout layout);
+
+    [[nodiscard]] PackedNormal &_texelAt(const int32_t x, const int32_t y) {
+        return m_texels[TexelAddressing::index(m_layout, m_stride, x, y)];
+    }
+
+    [[nodiscard]] const PackedNormal &_texelAt(const int32_t x, const int32_t y) const {
+        return m_data[TexelAddressing::index(m_layout, m_stride, x, y)];
+    }
+
+    // ------------------------------
+    // Class fields
+    // ------------------------------
+
+    static constexpr float SNORM_SCALE = 32767.0f;
+
+    /* rows per thread pool task for the cheap per texel loops */
+    static constexpr size_t ROWS_PER_TASK = 16;
+
+    int32_t m_width{};
+    int32_t m_height{};
+    int32_t m_stride{};
+    float m_xScale{};
+    float m_yScale{};
+
+    TexelLayout m_layout{};
+
+    /* texels are either owned or mapped straight from the cache file */
+    const PackedNormal *m_data{};
+    std::vector<PackedNormal> m_texels{};
+    std::unique_ptr<QFile> m_mappedFile{};
+};
+
+inline NormalMap::PackedNormal NormalMap::encode(const float3 &normal) {
+    const float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    float x = normal.x / l1;
+    float y = normal.y / l1;
+
+    /* fold lower hemisphere onto the diagonals */
+    if (normal.z < 0.0f) {
+        const float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    return {
+        static_cast<int16_t>(std::lround(std::clamp(x, -1.0f, 1.0f) * SNORM_SCALE)),
+        static_cast<int16_t>(std::lround(std::clamp(y, -1.0f, 1.0f) * SNORM_SCALE))
+    };
+}
+
+inline float3 NormalMap::decode(const PackedNormal packed) {
+    float x = static_cast<float>(packed.x) / SNORM_SCALE;
+    float y = static_cast<float>(packed.y) / SNORM_SCALE;
+    const float z = 1.0f - std::abs(x) - std::abs(y);
+
+    const float t = std::max(-z, 0.0f);
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+
+    return normalize(float3(x, y, z));
+}
+
+#endif //NORMALMAP_H
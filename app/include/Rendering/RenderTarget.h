@@ -0,0 +1,59 @@
+//
+// Created by Jlisowskyy on 11/12/24.
+//
+
+#ifndef RENDERTARGET_H
+#define RENDERTARGET_H
+
+/* internal includes */
+#include "BitMap.h"
+
+/* external includes */
+#include <cinttypes>
+#include <vector>
+
+/* Color and depth buffers reused between frames - storage only grows, geometrically */
+class RenderTarget {
+    // ------------------------------
+    // Class creation
+    // ------------------------------
+public:
+    RenderTarget();
+
+    ~RenderTarget() = default;
+
+    RenderTarget(const RenderTarget &) = delete;
+
+    RenderTarget &operator=(const RenderTarget &) = delete;
+
+    // ------------------------------
+    // Class interaction
+    // ------------------------------
+
+    void resize(int32_t width, int32_t height);
+
+    [[nodiscard]] BitMap &getBitMap() {
+        return m_bitMap;
+    }
+
+    [[nodiscard]] int16_t *getZBuffer() {
+        return m_zBuffer.data();
+    }
+
+    [[nodiscard]] int32_t width() const {
+        return m_bitMap.width();
+    }
+
+    [[nodiscard]] int32_t height() const {
+        return m_bitMap.height();
+    }
+
+    // ------------------------------
+    // Class fields
+    // ------------------------------
+protected:
+    BitMap m_bitMap;
+    std::vector<int16_t> m_zBuffer{};
+};
+
+#endif //RENDERTARGET_H
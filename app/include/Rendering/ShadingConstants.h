@@ -0,0 +1,45 @@
+//
+// Created by Jlisowskyy on 11/15/24.
+//
+
+#ifndef SHADINGCONSTANTS_H
+#define SHADINGCONSTANTS_H
+
+/* internal includes */
+#include "LightGrid.h"
+
+/* external includes */
+#include <array>
+#include <memory>
+#include <vector>
+
+/* Forward Declarations */
+class NormalMap;
+
+/* Lighting state fixed for a whole render pass - built once by Texture::prepareShading and only read by the shading
+ * kernels, so no pixel recomputes it from the Texture settings */
+struct ShadingConstants {
+    /* lights reaching every screen tile, colors premultiplied by kd and ks */
+    LightGrid lightGrid{};
+    float specularExponent{};
+
+    /* ambient light color scaled by ka - multiplied by the occlusion of the shaded point */
+    float3 ambient{};
+
+    /* orthographic projection - every pixel looks along the same direction */
+    float3 viewDir{0.0f, 0.0f, 1.0f};
+
+    /* world units per rasterizer unit - shadow maps are looked up in world space */
+    float worldScale{1.0f};
+
+    /* object space normals and the mesh rotation applied to them, null when normal mapping is off - shared, so the
+     * pass keeps its map alive when a new one gets loaded or baked meanwhile */
+    std::shared_ptr<const NormalMap> normalMap{};
+    std::array<float3, 3> normalRotation{};
+
+    /* per vertex model - light reaching every unique mesh vertex, indexed by Vertex::index */
+    ShadingModel model{ShadingModel::PER_PIXEL};
+    std::vector<float3> vertexLight{};
+};
+
+#endif //SHADINGCONSTANTS_H
@@ -0,0 +1,78 @@
+//
+// Created by Jlisowskyy on 11/16/24.
+//
+
+#ifndef SHADOWMAP_H
+#define SHADOWMAP_H
+
+/* internal includes */
+#include "../Intf.h"
+
+/* external includes */
+#include <cinttypes>
+#include <vector>
+
+/* Depth of the mesh as seen from a single light looking at the scene origin. Built by a depth-only rasterizer -
+ * no uv, normals nor colors - and kept until the mesh or the light moves. */
+class ShadowMap {
+    // ------------------------------
+    // Class creation
+    // ------------------------------
+public:
+    static constexpr int32_t SIZE = LIGHTING_CONSTANTS::SHADOW_MAP_SIZE;
+
+    ShadowMap() = default;
+
+    ~ShadowMap() = default;
+
+    ShadowMap(const ShadowMap &) = delete;
+
+    ShadowMap &operator=(const ShadowMap &) = delete;
+
+    // ------------------------------
+    // Class interaction
+    // ------------------------------
+
+    /* triangles in world space - rotated positions of the full resolution mesh */
+    void build(const float3 &lightPosition, const MeshArr &triangles, uint64_t meshRevision);
+
+    /* small light moves are ignored - shadows shift by a fraction of a texel only */
+    [[nodiscard]] bool isValidFor(const float3 &lightPosition, uint64_t meshRevision) const;
+
+    /* fraction of the PCF taps around the world space point which see the light */
+    [[nodiscard]] float visibility(const float3 &worldPos) const;
+
+    // ------------------------------
+    // Class protected methods
+    // ------------------------------
+protected:
+    /* map coordinates in x, y and distance along the light axis in z */
+    [[nodiscard]] float3 _project(const float3 &worldPos) const;
+
+    void _rasterizeDepth(const float3 &p0, const float3 &p1, const float3 &p2);
+
+    // ------------------------------
+    // Class fields
+    // ------------------------------
+
+    /* anything closer to the light is not stored */
+    static constexpr float NEAR_PLANE = 1.0f;
+
+    /* used when the light is inside the bounding sphere of the mesh */
+    static constexpr float MAX_TAN_HALF_FOV = 4.0f;
+
+    bool m_isBuilt{};
+    uint64_t m_meshRevision{};
+    float3 m_lightPosition{};
+
+    /* light space basis, forward points at the scene origin */
+    float3 m_right{};
+    float3 m_up{};
+    float3 m_forward{};
+    float m_focal{};
+
+    /* reciprocal of the closest depth per texel - linear in map space, 0 when nothing was rasterized */
+    std::vector<float> m_invDepth{};
+};
+
+#endif //SHADOWMAP_H
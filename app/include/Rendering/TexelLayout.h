@@ -0,0 +1,70 @@
+//
+// Created by Jlisowskyy on 11/13/24.
+//
+
+#ifndef TEXELLAYOUT_H
+#define TEXELLAYOUT_H
+
+/* external includes */
+#include <cinttypes>
+#include <cstddef>
+
+/* Memory order of texels inside a single image level */
+enum class TexelLayout {
+    ROW_MAJOR,
+    /* 4x4 blocks stored contiguously - a rotated surface walks the texture diagonally, blocks keep neighbours in the
+     * same cache lines */
+    TILED_4X4,
+};
+
+/* Address computation shared by all texel storages */
+namespace TexelAddressing {
+    static constexpr int32_t TILE_SHIFT = 2;
+    static constexpr int32_t TILE_SIZE = 1 << TILE_SHIFT;
+    static constexpr int32_t TILE_MASK = TILE_SIZE - 1;
+
+    /* row-major: texels per row, tiled: tiles per row */
+    [[nodiscard]] inline int32_t stride(const TexelLayout layout, const int32_t width) {
+        return layout == TexelLayout::ROW_MAJOR ? width : (width + TILE_MASK) >> TILE_SHIFT;
+    }
+
+    /* partial tiles at the edges are padded, padding is never sampled */
+    [[nodiscard]] inline size_t size(const TexelLayout layout, const int32_t width, const int32_t height) {
+        if (layout == TexelLayout::ROW_MAJOR) {
+            return static_cast<size_t>(width) * height;
+        }
+
+        const size_t tilesX = (width + TILE_MASK) >> TILE_SHIFT;
+        const size_t tilesY = (height + TILE_MASK) >> TILE_SHIFT;
+        return tilesX * tilesY * TILE_SIZE * TILE_SIZE;
+    }
+
+    [[nodiscard]] inline size_t index(const TexelLayout layout, const int32_t stride, const int32_t x,
+                                      const int32_t y) {
+        if (layout == TexelLayout::ROW_MAJOR) {
+            return static_cast<size_t>(y) * stride + x;
+        }
+
+        const size_t tile = static_cast<size_t>(y >> TILE_SHIFT) * stride + (x >> TILE_SHIFT);
+        return (tile << (2 * TILE_SHIFT)) + ((y & TILE_MASK) << TILE_SHIFT) + (x & TILE_MASK);
+    }
+
+    /* Sampling coordinate limited to [0, maxCoord] - scaled (u, v) may leave [0, 1] slightly and degenerate
+     * triangles even produce NaN, which maps to 0 here. Texel indices truncated from the result stay inside the
+     * level. */
+    [[nodiscard]] inline float clampCoord(const float coord, const float maxCoord) {
+        return coord > 0.0f ? (coord < maxCoord ? coord : maxCoord) : 0.0f;
+    }
+
+    /* number of consecutive texels of row y starting at x that are contiguous in memory */
+    [[nodiscard]] inline int32_t runLength(const TexelLayout layout, const int32_t width, const int32_t x) {
+        if (layout == TexelLayout::ROW_MAJOR) {
+            return width - x;
+        }
+
+        const int32_t tileEnd = (x & ~TILE_MASK) + TILE_SIZE;
+        return (tileEnd < width ? tileEnd : width) - x;
+    }
+}
+
+#endif //TEXELLAYOUT_H
@@ -9,6 +9,14 @@
 #include "../Intf.h"
 #include "../Rendering/Mesh.h"
 #include "../Rendering/BitMap.h"
+#include "../Rendering/TextureImage.h"
+#include "../Rendering/NormalMap.h"
+#include "../Rendering/LightSet.h"
+#include "../Rendering/LightGrid.h"
+#include "../Rendering/ShadingConstants.h"
+#include "../Rendering/ShadowMap.h"
+#include "../Rendering/FastMath.h"
+#include "../ManagingObjects/ThreadPool.h"
 
 /* external includes */
 #include <QObject>
@@ -19,6 +27,9 @@
 #include <chrono>
 #include <QDebug>
 #include <QMatrix3x3>
+#include <array>
+#include <memory>
+#include <vector>
 
 class Texture : public QObject {
     Q_OBJECT
@@ -28,8 +39,8 @@ public:
     // Class creation
     // ------------------------------
 
-    Texture(QObject *parent, float ksCoef, float kdCoef, float mCoef, const QColor &lightColor, bool useReflector,
-            float reflectorCoef);
+    Texture(QObject *parent, float kaCoef, float ksCoef, float kdCoef, float mCoef, const QColor &lightColor,
+            bool useReflector);
 
     ~Texture() override = default;
 
@@ -38,25 +49,52 @@ public:
     // ------------------------------
 
     template<bool useNormals, typename ColorGetterT>
-    void fillPixmap(QPixmap &pixmap, const Mesh &mesh, ColorGetterT colorGetter, const QVector3D &lightPos) const;
+    void fillPixmap(QPixmap &pixmap, const Mesh &mesh, ColorGetterT colorGetter,
+                    const std::vector<LightSource> &lightSources);
+
+    /* Frame stages - allow the triangles of a single frame to be rasterized in several slices */
+    static void prepareFrame(BitMap &bitMap, int16_t *zBuffer);
+
+    /* Must precede drawing - snapshots current settings into shading. Light sources are given in world space,
+     * triangles in the rasterizer coordinates of width x height target - world scaled by scale. Normal mapping rebakes
+     * object space map when the surface changed, shadows rebuild stale shadow maps, per vertex model lights all the
+     * vertices of triangles. */
+    void prepareShading(ShadingConstants &shading, const Mesh &mesh, const MeshArr &triangles,
+                        const std::vector<LightSource> &lightSources, float scale, int32_t width, int32_t height,
+                        bool useNormals, bool useShadows, ShadingModel model);
+
+    /* Screen is split into horizontal bands of THREAD_CONSTANTS::RASTER_BAND_HEIGHT rows, each band is one thread
+     * pool task drawing its binned triangles in order - no two threads ever touch the same pixel */
+    template<bool useNormals, typename ColorGetterT>
+    void drawTriangles(BitMap &bitMap, int16_t *zBuffer, const MeshArr &triangles, size_t begin, size_t end,
+                       ColorGetterT colorGetter, const ShadingConstants &shading) const;
+
+    void finishFrame(QPixmap &pixmap, BitMap &bitMap, int16_t *zBuffer, const MeshArr &triangles,
+                     const MeshArr &figure, const Mesh &mesh, std::chrono::nanoseconds frameTime) const;
 
+    /* writes screen rows [bandBegin, bandEnd) only */
     template<bool useNormals, typename ColorGetterT, size_t N>
     void colorPolygon(BitMap &bitMap, int16_t *zBuffer, ColorGetterT colorGet, const PolygonArr<N> &polygon,
-                      const QVector3D &lightPos) const;
+                      const ShadingConstants &shading, int32_t bandBegin, int32_t bandEnd) const;
 
     template<bool useNormals, size_t N>
     void colorFigure(BitMap &bitMap, int16_t *zBuffer, QColor color, const PolygonArr<N> &polygon,
-                     const QVector3D &lightPos) const;
+                     const LightSet &lights) const;
 
     // ------------------------------
     // Public slots
     // ------------------------------
 
 public slots:
+    /* ambient part only - direct light comes with the light sources */
     void setLightColor(const QColor &lightColor) {
         m_lightColor = lightColor;
     }
 
+    void setKaCoef(const float kaCoef) {
+        m_kaCoef = kaCoef;
+    }
+
     void setKsCoef(const float ksCoef) {
         m_ksCoef = ksCoef;
     }
@@ -69,13 +107,14 @@ public slots:
         m_mCoef = mCoef;
     }
 
-    void setNormalMap(QImage *image) {
+    void setNormalMap(NormalMap *image) {
         if (image == m_normalMap) {
             return;
         }
 
         delete m_normalMap;
         m_normalMap = image;
+        m_objectNormalMap.reset();
     }
 
     void setDrawNet(const bool drawNet) {
@@ -86,8 +125,8 @@ public slots:
         m_drawReflector = useReflector;
     }
 
-    void setReflectorCoef(const float reflectorCoef) {
-        m_reflectorCoef = reflectorCoef;
+    void setUseShadows(const bool useShadows) {
+        m_useShadows = useShadows;
     }
 
     // ------------------------------
@@ -95,35 +134,95 @@ public slots:
     // ------------------------------
 protected:
     struct _drawData {
-        QVector3D v0;
-        QVector3D v1;
+        float3 v0;
+        float3 v1;
 
         float d00;
         float d01;
         float d11;
     };
 
+    /* z-tested pixels of a single span waiting for batched texture sampling */
+    struct _PixelBatch {
+        static constexpr size_t SIZE = TextureImage::SAMPLE_BATCH_SIZE;
+
+        size_t count{};
+        std::array<int, SIZE> screenX{};
+        std::array<float, SIZE> u{};
+        std::array<float, SIZE> v{};
+        /* per pixel model - normals get normalized all at once before shading */
+        float3Batch<SIZE> pos{};
+        float3Batch<SIZE> normal{};
+        std::array<float, SIZE> ao{};
+
+        /* per vertex model */
+        float3Batch<SIZE> light{};
+    };
+
+    /* Light set of the current frame - material coefficients applied to the light sources, moved into the rasterizer
+     * space by scale */
+    [[nodiscard]] LightSet _createLights(const std::vector<LightSource> &lightSources, float scale,
+                                         const std::vector<const ShadowMap *> &shadowMaps) const;
+
+    /* one map per light, only the stale ones are rebuilt */
+    [[nodiscard]] std::vector<const ShadowMap *> _prepareShadowMaps(const Mesh &mesh,
+                                                                    const std::vector<float3> &positions);
+
+    /* rebakes object space map when the surface changed */
+    void _prepareNormalMap(const Mesh &mesh);
+
+    /* light of every unique vertex of triangles */
+    static void _computeVertexLights(ShadingConstants &shading, const MeshArr &triangles);
+
+    [[nodiscard]] static std::array<float, 3> _computeBarycentric(const float3 &pos, const Triangle &triangle,
+                                                                  const _drawData &drawData);
+
     template<bool useNormals>
-    [[nodiscard]] std::tuple<float, float, QVector3D>
-    _interpolateFromTrianglePoint(const QVector3D &pos, const Triangle &triangle, const _drawData &drawData) const;
+    [[nodiscard]] static std::tuple<float, float, float3>
+    _interpolateFromTrianglePoint(const std::array<float, 3> &weights, const Triangle &triangle,
+                                  const ShadingConstants &shading);
+
+    [[nodiscard]] static float3 _interpolateVertexLight(const std::array<float, 3> &weights,
+                                                        const Triangle &triangle, const ShadingConstants &shading);
+
+    [[nodiscard]] static float _interpolateAo(const std::array<float, 3> &weights, const Triangle &triangle) {
+        return weights[0] * triangle[0].ao + weights[1] * triangle[1].ao + weights[2] * triangle[2].ao;
+    }
 
-    [[nodiscard]] QColor _applyLightToTriangleColor(const QColor &color, const QVector3D &normalVector,
-                                                    const QVector3D &pos, const QVector3D &lightPos) const;
+    [[nodiscard]] float3 _getLightColor() const;
+
+    /* light reaching the point per color channel, already scaled by material coefficients - expects unit normal */
+    [[nodiscard]] static float3 _computeLight(const float3 &normalVector, const float3 &pos, const LightSet &lights,
+                                              const ShadingConstants &shading);
+
+    [[nodiscard]] static QRgb _applyLightToColor(QRgb color, const float3 &light);
 
     template<bool useNormals, typename ColorGetterT>
-    [[nodiscard]] QColor _processColor(ColorGetterT colorGetter, const QVector3D &pos, const Triangle &triangle,
-                                       const QVector3D &lightPos, const _drawData &drawData) const;
+    [[nodiscard]] static QRgb _processColor(ColorGetterT colorGetter, const float3 &pos, const Triangle &triangle,
+                                            const ShadingConstants &shading, const LightSet &lights,
+                                            const _drawData &drawData, float lod);
+
+    template<typename ColorGetterT>
+    static void _flushPixelBatch(BitMap &bitMap, int screenY, _PixelBatch &batch, ColorGetterT colorGetter,
+                                 const ShadingConstants &shading, float lod);
 
     [[nodiscard]] static _drawData _preprocess(const Triangle &triangle);
 
-    static void _drawLineOwn(const QVector3D &from, const QVector3D &to, BitMap &bitMap, int16_t *zBuffer);
+    /* uv is affine in screen space under orthographic projection - gradient is constant over the whole triangle */
+    [[nodiscard]] static UvGradient _computeUvGradient(const Triangle &triangle);
+
+    static void _drawLineOwn(const float3 &from, const float3 &to, BitMap &bitMap, int16_t *zBuffer);
 
-    QVector3D _findNormal(const QVector3D &pos, const Triangle &triangle) const;
+    float3 _findNormal(const float3 &pos, const Triangle &triangle) const;
 
     // ------------------------------
     // Class fields
     // ------------------------------
 
+    /* thread pool grain of the per vertex lighting */
+    static constexpr size_t VERTICES_PER_TASK = 256;
+
+    float m_kaCoef{};
     float m_ksCoef{};
     float m_kdCoef{};
     float m_mCoef{};
@@ -131,83 +230,98 @@ protected:
 
     bool m_drawNet{};
 
-    QImage *m_normalMap{};
+    NormalMap *m_normalMap{};
+
+    /* m_normalMap resolved against m_bakedControlPoints, shared with the passes still shading with it */
+    std::shared_ptr<const NormalMap> m_objectNormalMap{};
+    ControlPoints m_bakedControlPoints{};
 
-    float m_reflectorCoef{};
     bool m_drawReflector{};
+
+    bool m_useShadows{LIGHTING_CONSTANTS::DEFAULT_USE_SHADOWS};
+    /* pointers stay valid while the light count does not shrink - passes keep referring to them */
+    std::vector<std::unique_ptr<ShadowMap>> m_shadowMaps{};
 };
 
 template<bool useNormals, typename ColorGetterT>
-void Texture::fillPixmap(QPixmap &pixmap, const Mesh &mesh, ColorGetterT colorGetter, const QVector3D &lightPos) const {
+void Texture::fillPixmap(QPixmap &pixmap, const Mesh &mesh, ColorGetterT colorGetter,
+                         const std::vector<LightSource> &lightSources) {
     const auto t0 = std::chrono::steady_clock::now();
     const size_t zBufferSize = pixmap.width() * pixmap.height();
 
     const auto zBuffer = static_cast<int16_t *>(malloc(sizeof(int16_t) * zBufferSize));
-    for (size_t z = 0; z < zBufferSize; ++z) {
-        zBuffer[z] = INT16_MIN;
-    }
-
     BitMap bitMap(pixmap.width(), pixmap.height());
-    bitMap.setWhiteAll();
+    prepareFrame(bitMap, zBuffer);
 
-#pragma omp parallel for schedule(static)
-    for (const auto &triangle: mesh.getMeshArr()) {
-        colorPolygon<useNormals>(bitMap, zBuffer, colorGetter, triangle, lightPos);
-    }
+    ShadingConstants shading{};
+    prepareShading(shading, mesh, mesh.getMeshArr(), lightSources, 1.0f, bitMap.width(), bitMap.height(),
+                   useNormals, true, ShadingModel::PER_PIXEL);
 
-    if (m_drawNet) {
-        for (const auto &triangle: mesh.getMeshArr()) {
-            for (size_t i = 0; i < 3; i++) {
-                const auto &v1 = triangle[i].rotatedPosition;
-                const auto &v2 = triangle[(i + 1) % 3].rotatedPosition;
+    drawTriangles<useNormals>(bitMap, zBuffer, mesh.getMeshArr(), 0, mesh.getMeshArr().size(), colorGetter,
+                              shading);
 
-                _drawLineOwn(v1, v2, bitMap, zBuffer);
-            }
-        }
-    }
+    const auto t1 = std::chrono::steady_clock::now();
+    finishFrame(pixmap, bitMap, zBuffer, mesh.getMeshArr(), mesh.getFigure(), mesh, t1 - t0);
 
-    size_t idx = 0;
-    for (const auto &triangle: mesh.getFigure()) {
-        const QColor color = mesh.getFigureColor(idx++);
-        colorFigure<false>(bitMap, zBuffer, color, triangle, lightPos);
+    free(zBuffer);
+}
 
-        for (size_t i = 0; i < 3; i++) {
-            const auto &v1 = triangle[i].rotatedPosition;
-            const auto &v2 = triangle[(i + 1) % 3].rotatedPosition;
+template<bool useNormals, typename ColorGetterT>
+void Texture::drawTriangles(BitMap &bitMap, int16_t *zBuffer, const MeshArr &triangles, const size_t begin,
+                            const size_t end, ColorGetterT colorGetter, const ShadingConstants &shading) const {
+    Q_ASSERT(begin <= end && end <= triangles.size());
 
-            _drawLineOwn(v1, v2, bitMap, zBuffer);
-        }
+    static constexpr int32_t BAND_HEIGHT = THREAD_CONSTANTS::RASTER_BAND_HEIGHT;
+
+    const int32_t height = bitMap.height();
+    const int32_t bandCount = (height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+
+    if (bandCount <= 0) {
+        return;
     }
 
-    bitMap.dropToPixMap(pixmap);
+    /* bins keep the submission order - z ties resolve the same way as in a serial draw */
+    std::vector<std::vector<uint32_t> > bands(bandCount);
 
-    const auto t1 = std::chrono::steady_clock::now();
-    const auto t = t1 - t0;
+    for (size_t idx = begin; idx < end; ++idx) {
+        const Triangle &triangle = triangles[idx];
 
-    qDebug() << "Time spent on drawing texture: " << t.count() << " ns";
+        const float minY = std::min({
+            triangle[0].rotatedPosition.y, triangle[1].rotatedPosition.y, triangle[2].rotatedPosition.y
+        });
+        const float maxY = std::max({
+            triangle[0].rotatedPosition.y, triangle[1].rotatedPosition.y, triangle[2].rotatedPosition.y
+        });
 
-    const auto tm = std::chrono::duration_cast<std::chrono::milliseconds>(t);
+        /* one row margin - scanlines start at floored vertex rows */
+        const int32_t firstRow = static_cast<int32_t>(std::floor(minY)) - 1 + height / 2;
+        const int32_t lastRow = static_cast<int32_t>(std::ceil(maxY)) + 1 + height / 2;
 
-    QPainter painter(&pixmap);
+        if (lastRow < 0 || firstRow >= height) {
+            continue;
+        }
 
-    painter.setPen(QPen(Qt::black, 2));
+        const int32_t firstBand = std::max(firstRow, 0) / BAND_HEIGHT;
+        const int32_t lastBand = std::min(lastRow, height - 1) / BAND_HEIGHT;
 
-    QFont font{};
-    font.setFamily("Courier");
-    font.setPointSize(UI_CONSTANTS::DEFAULT_FPS_SIZE);
-    font.setBold(true);
-    painter.setFont(font);
-    painter.setPen(Qt::black);
-    painter.setBrush(Qt::black);
+        for (int32_t band = firstBand; band <= lastBand; ++band) {
+            bands[band].push_back(static_cast<uint32_t>(idx));
+        }
+    }
 
-    painter.drawText(0, 20, "Fps: " + QString::number(1000.0 / static_cast<double>(tm.count())));
+    ThreadPool::getInstance().parallelFor(0, bandCount, 1, [&](const size_t band) {
+        const auto bandBegin = static_cast<int32_t>(band) * BAND_HEIGHT;
+        const int32_t bandEnd = std::min(bandBegin + BAND_HEIGHT, height);
 
-    free(zBuffer);
+        for (const uint32_t idx: bands[band]) {
+            colorPolygon<useNormals>(bitMap, zBuffer, colorGetter, triangles[idx], shading, bandBegin, bandEnd);
+        }
+    });
 }
 
 template<bool useNormals, typename ColorGetterT, size_t N>
 void Texture::colorPolygon(BitMap &bitMap, int16_t *zBuffer, ColorGetterT colorGet, const PolygonArr<N> &polygon,
-                           const QVector3D &lightPos) const {
+                           const ShadingConstants &shading, const int32_t bandBegin, const int32_t bandEnd) const {
     std::array<size_t, N> sorted{};
     for (size_t i = 0; i < N; i++) {
         sorted[i] = i;
@@ -217,7 +331,7 @@ void Texture::colorPolygon(BitMap &bitMap, int16_t *zBuffer, ColorGetterT colorG
         size_t key = sorted[i];
         int j = i - 1;
 
-        while (j >= 0 && polygon[sorted[j]].rotatedPosition.y() > polygon[key].rotatedPosition.y()) {
+        while (j >= 0 && polygon[sorted[j]].rotatedPosition.y > polygon[key].rotatedPosition.y) {
             sorted[j + 1] = sorted[j];
             j--;
         }
@@ -225,22 +339,23 @@ void Texture::colorPolygon(BitMap &bitMap, int16_t *zBuffer, ColorGetterT colorG
     }
 
     std::list<ActiveEdge> aet{};
-    int scanLineY = static_cast<int>(std::floor(polygon[sorted[0]].rotatedPosition.y()));
+    int scanLineY = static_cast<int>(std::floor(polygon[sorted[0]].rotatedPosition.y));
     size_t nextVertex = 0;
 
     /* works only for triangles */
     _drawData drawData = _preprocess(polygon);
+    const float lod = colorGet.computeLod(_computeUvGradient(polygon));
 
     while (nextVertex < N || !aet.empty()) {
         while (nextVertex < N &&
-               static_cast<int>(std::floor(polygon[sorted[nextVertex]].rotatedPosition.y())) == scanLineY) {
+               static_cast<int>(std::floor(polygon[sorted[nextVertex]].rotatedPosition.y)) == scanLineY) {
             const size_t curr = sorted[nextVertex];
             const size_t prev = (curr + N - 1) % N;
             const size_t next = (curr + 1) % N;
 
-            const float currY = polygon[curr].rotatedPosition.y();
-            const float prevY = polygon[prev].rotatedPosition.y();
-            const float nextY = polygon[next].rotatedPosition.y();
+            const float currY = polygon[curr].rotatedPosition.y;
+            const float prevY = polygon[prev].rotatedPosition.y;
+            const float nextY = polygon[next].rotatedPosition.y;
 
             if (prevY > currY) {
                 aet.emplace_back(
@@ -259,12 +374,22 @@ void Texture::colorPolygon(BitMap &bitMap, int16_t *zBuffer, ColorGetterT colorG
             nextVertex++;
         }
 
-        aet.sort([](const ActiveEdge &a, const ActiveEdge &b) {
-            return a.x < b.x || (a.x == b.x && a.dx < b.dx);
-        });
+        const int screenY = scanLineY + bitMap.height() / 2;
+
+        /* rows below the band belong to later tasks */
+        if (screenY >= bandEnd) {
+            break;
+        }
+
+        /* rows above the band only advance the edges */
+        if (screenY >= bandBegin) {
+            aet.sort([](const ActiveEdge &a, const ActiveEdge &b) {
+                return a.x < b.x || (a.x == b.x && a.dx < b.dx);
+            });
+        }
 
         auto it = aet.begin();
-        while (it != aet.end() && std::next(it) != aet.end()) {
+        while (screenY >= bandBegin && it != aet.end() && std::next(it) != aet.end()) {
             int x1 = static_cast<int>(std::floor(it->x));
             int x2 = static_cast<int>(std::ceil(std::next(it)->x));
 
@@ -272,30 +397,50 @@ void Texture::colorPolygon(BitMap &bitMap, int16_t *zBuffer, ColorGetterT colorG
             float zRight = std::next(it)->z;
             float zStep = (x2 - x1) != 0 ? (zRight - zLeft) / static_cast<float>(x2 - x1) : 0.0f;
 
+            /* texels of visible pixels are fetched in batches - lets the sampler work on several lanes at once */
+            _PixelBatch batch{};
+
             for (int x = x1; x <= x2; x++) {
                 float z = zLeft + static_cast<float>(x - x1) * zStep;
 
                 const int screenX = x + bitMap.width() / 2;
-                const int screenY = scanLineY + bitMap.height() / 2;
 
                 if (screenX >= 0 && screenX < bitMap.width() && screenY >= 0 && screenY < bitMap.height()) {
                     if (const auto zRounded = static_cast<int16_t>(std::floor(z));
                         zRounded > zBuffer[screenY * bitMap.width() + screenX]) {
                         zBuffer[screenY * bitMap.width() + screenX] = zRounded;
 
-                        const QVector3D drawPoint{
+                        const float3 drawPoint{
                             static_cast<float>(x),
                             static_cast<float>(scanLineY),
                             z
                         };
 
-                        const QColor color = _processColor<
-                            useNormals>(colorGet, drawPoint, polygon, lightPos, drawData);
-                        bitMap.setColorAt(screenX, screenY, color);
+                        const auto weights = _computeBarycentric(drawPoint, polygon, drawData);
+                        const auto [u, v, normal] = _interpolateFromTrianglePoint<useNormals>(
+                            weights, polygon, shading);
+
+                        batch.screenX[batch.count] = screenX;
+                        batch.u[batch.count] = u;
+                        batch.v[batch.count] = v;
+
+                        if (shading.model == ShadingModel::PER_VERTEX) {
+                            batch.light.set(batch.count, _interpolateVertexLight(weights, polygon, shading));
+                        } else {
+                            batch.pos.set(batch.count, drawPoint);
+                            batch.normal.set(batch.count, normal);
+                            batch.ao[batch.count] = _interpolateAo(weights, polygon);
+                        }
+
+                        if (++batch.count == _PixelBatch::SIZE) {
+                            _flushPixelBatch(bitMap, screenY, batch, colorGet, shading, lod);
+                        }
                     }
                 }
             }
 
+            _flushPixelBatch(bitMap, screenY, batch, colorGet, shading, lod);
+
             std::advance(it, 2);
         }
 
@@ -314,30 +459,37 @@ void Texture::colorPolygon(BitMap &bitMap, int16_t *zBuffer, ColorGetterT colorG
         const auto &v1 = polygon[i].rotatedPosition;
         const auto &v2 = polygon[(i + 1) % N].rotatedPosition;
 
-        if (std::abs(v1.y() - v2.y()) <= 1.0f) {
-            const int y = static_cast<int>(std::floor(v1.y()));
-            const int x1 = static_cast<int>(std::floor(std::min(v1.x(), v2.x())));
-            const int x2 = static_cast<int>(std::floor(std::max(v1.x(), v2.x())));
+        if (std::abs(v1.y - v2.y) <= 1.0f) {
+            const int y = static_cast<int>(std::floor(v1.y));
+            const int x1 = static_cast<int>(std::floor(std::min(v1.x, v2.x)));
+            const int x2 = static_cast<int>(std::floor(std::max(v1.x, v2.x)));
 
-            const float zStart = v1.z();
-            const float zEnd = v2.z();
+            const float zStart = v1.z;
+            const float zEnd = v2.z;
             const float zStep = x2 - x1 != 0 ? (zEnd - zStart) / (x2 - x1) : 0.0f;
 
+            const int screenY = y + bitMap.height() / 2;
+
+            if (screenY < bandBegin || screenY >= bandEnd) {
+                continue;
+            }
+
             for (int x = x1; x <= x2; ++x) {
                 float z = zStart + (x - x1) * zStep;
 
                 const int screenX = x + bitMap.width() / 2;
-                const int screenY = y + bitMap.height() / 2;
 
-                if (screenX >= 0 && screenX < bitMap.width() && screenY >= 0 && screenY < bitMap.height()) {
-                    const QVector3D drawPoint{
+                if (screenX >= 0 && screenX < bitMap.width()) {
+                    const float3 drawPoint{
                         static_cast<float>(x),
-                        static_cast<float>(scanLineY),
+                        static_cast<float>(y),
                         z
                     };
 
-                    const QColor color = _processColor<useNormals>(colorGet, drawPoint, polygon, lightPos, drawData);
-                    bitMap.setColorAt(screenX, screenY, color);
+                    const QRgb color = _processColor<useNormals>(colorGet, drawPoint, polygon, shading,
+                                                                 shading.lightGrid.lightsAt(screenX, screenY),
+                                                                 drawData, lod);
+                    bitMap.setRgbAt(screenX, screenY, color);
                 }
             }
         }
@@ -346,7 +498,7 @@ void Texture::colorPolygon(BitMap &bitMap, int16_t *zBuffer, ColorGetterT colorG
 
 template<bool useNormals, size_t N>
 void Texture::colorFigure(BitMap &bitMap, int16_t *zBuffer, QColor color, const PolygonArr<N> &polygon,
-                          const QVector3D &lightPos) const {
+                          const LightSet &lights) const {
     std::array<size_t, N> sorted{};
     for (size_t i = 0; i < N; i++) {
         sorted[i] = i;
@@ -356,7 +508,7 @@ void Texture::colorFigure(BitMap &bitMap, int16_t *zBuffer, QColor color, const
         size_t key = sorted[i];
         int j = i - 1;
 
-        while (j >= 0 && polygon[sorted[j]].rotatedPosition.y() > polygon[key].rotatedPosition.y()) {
+        while (j >= 0 && polygon[sorted[j]].rotatedPosition.y > polygon[key].rotatedPosition.y) {
             sorted[j + 1] = sorted[j];
             j--;
         }
@@ -364,7 +516,7 @@ void Texture::colorFigure(BitMap &bitMap, int16_t *zBuffer, QColor color, const
     }
 
     std::list<ActiveEdge> aet{};
-    int scanLineY = static_cast<int>(std::floor(polygon[sorted[0]].rotatedPosition.y()));
+    int scanLineY = static_cast<int>(std::floor(polygon[sorted[0]].rotatedPosition.y));
     size_t nextVertex = 0;
 
     /* works only for triangles */
@@ -372,14 +524,14 @@ void Texture::colorFigure(BitMap &bitMap, int16_t *zBuffer, QColor color, const
 
     while (nextVertex < N || !aet.empty()) {
         while (nextVertex < N &&
-               static_cast<int>(std::floor(polygon[sorted[nextVertex]].rotatedPosition.y())) == scanLineY) {
+               static_cast<int>(std::floor(polygon[sorted[nextVertex]].rotatedPosition.y)) == scanLineY) {
             const size_t curr = sorted[nextVertex];
             const size_t prev = (curr + N - 1) % N;
             const size_t next = (curr + 1) % N;
 
-            const float currY = polygon[curr].rotatedPosition.y();
-            const float prevY = polygon[prev].rotatedPosition.y();
-            const float nextY = polygon[next].rotatedPosition.y();
+            const float currY = polygon[curr].rotatedPosition.y;
+            const float prevY = polygon[prev].rotatedPosition.y;
+            const float nextY = polygon[next].rotatedPosition.y;
 
             if (prevY > currY) {
                 aet.emplace_back(
@@ -422,14 +574,14 @@ void Texture::colorFigure(BitMap &bitMap, int16_t *zBuffer, QColor color, const
                         zRounded > zBuffer[screenY * bitMap.width() + screenX]) {
                         zBuffer[screenY * bitMap.width() + screenX] = zRounded;
 
-                        const QVector3D drawPoint{
+                        const float3 drawPoint{
                             static_cast<float>(x),
                             static_cast<float>(scanLineY),
                             z
                         };
 
 
-                        // color = _applyLightToTriangleColor(color, _findNormal(drawPoint, polygon), drawPoint, lightPos);
+                        // color = _applyLightToTriangleColor(color, _findNormal(drawPoint, polygon), drawPoint, lights);
                         bitMap.setColorAt(screenX, screenY, color);
                     }
                 }
@@ -453,13 +605,13 @@ void Texture::colorFigure(BitMap &bitMap, int16_t *zBuffer, QColor color, const
         const auto &v1 = polygon[i].rotatedPosition;
         const auto &v2 = polygon[(i + 1) % N].rotatedPosition;
 
-        if (std::abs(v1.y() - v2.y()) <= 1.0f) {
-            const int y = static_cast<int>(std::floor(v1.y()));
-            const int x1 = static_cast<int>(std::floor(std::min(v1.x(), v2.x())));
-            const int x2 = static_cast<int>(std::floor(std::max(v1.x(), v2.x())));
+        if (std::abs(v1.y - v2.y) <= 1.0f) {
+            const int y = static_cast<int>(std::floor(v1.y));
+            const int x1 = static_cast<int>(std::floor(std::min(v1.x, v2.x)));
+            const int x2 = static_cast<int>(std::floor(std::max(v1.x, v2.x)));
 
-            const float zStart = v1.z();
-            const float zEnd = v2.z();
+            const float zStart = v1.z;
+            const float zEnd = v2.z;
             const float zStep = x2 - x1 != 0 ? (zEnd - zStart) / (x2 - x1) : 0.0f;
 
             for (int x = x1; x <= x2; ++x) {
@@ -469,13 +621,13 @@ void Texture::colorFigure(BitMap &bitMap, int16_t *zBuffer, QColor color, const
                 const int screenY = y + bitMap.height() / 2;
 
                 if (screenX >= 0 && screenX < bitMap.width() && screenY >= 0 && screenY < bitMap.height()) {
-                    const QVector3D drawPoint{
+                    const float3 drawPoint{
                         static_cast<float>(x),
                         static_cast<float>(scanLineY),
                         z
                     };
 
-                    // color = _applyLightToTriangleColor(color, _findNormal(drawPoint, polygon), drawPoint, lightPos);
+                    // color = _applyLightToTriangleColor(color, _findNormal(drawPoint, polygon), drawPoint, lights);
                     bitMap.setColorAt(screenX, screenY, color);
                 }
             }
@@ -484,74 +636,69 @@ void Texture::colorFigure(BitMap &bitMap, int16_t *zBuffer, QColor color, const
 }
 
 template<bool useNormals, typename ColorGetterT>
-QColor Texture::_processColor(ColorGetterT colorGetter, const QVector3D &pos, const Triangle &triangle,
-                              const QVector3D &lightPos, const _drawData &drawData) const {
-    const auto [u, v, interpolatedNormalVector] = _interpolateFromTrianglePoint<useNormals>(pos, triangle, drawData);
-    const QColor color = colorGetter(u, v);
-    return _applyLightToTriangleColor(color, interpolatedNormalVector, pos, lightPos);
+QRgb Texture::_processColor(ColorGetterT colorGetter, const float3 &pos, const Triangle &triangle,
+                            const ShadingConstants &shading, const LightSet &lights, const _drawData &drawData,
+                            const float lod) {
+    const auto weights = _computeBarycentric(pos, triangle, drawData);
+    const auto [u, v, interpolatedNormalVector] = _interpolateFromTrianglePoint<useNormals>(weights, triangle,
+                                                                                            shading);
+    const QRgb color = colorGetter(u, v, lod);
+    const float3 light = shading.model == ShadingModel::PER_VERTEX
+                             ? _interpolateVertexLight(weights, triangle, shading)
+                             : fmadd(shading.ambient, _interpolateAo(weights, triangle),
+                                     _computeLight(normalize(interpolatedNormalVector), pos, lights, shading));
+
+    return _applyLightToColor(color, light);
 }
 
-template<bool useNormals>
-std::tuple<float, float, QVector3D>
-Texture::_interpolateFromTrianglePoint(const QVector3D &pos, const Triangle &triangle,
-                                       const _drawData &drawData) const {
-    const QVector3D v2 = pos - triangle[0].rotatedPosition;
+template<typename ColorGetterT>
+void Texture::_flushPixelBatch(BitMap &bitMap, const int screenY, _PixelBatch &batch, ColorGetterT colorGetter,
+                               const ShadingConstants &shading, const float lod) {
+    if (batch.count == 0) {
+        return;
+    }
 
-    const float d20 = QVector3D::dotProduct(v2, drawData.v0);
-    const float d21 = QVector3D::dotProduct(v2, drawData.v1);
+    std::array<QRgb, _PixelBatch::SIZE> colors;
+    colorGetter.sampleBatch(batch.u.data(), batch.v.data(), lod, colors.data(), batch.count);
 
-    const float denom = drawData.d00 * drawData.d11 - drawData.d01 * drawData.d01;
-    const float v = (drawData.d11 * d20 - drawData.d01 * d21) / denom;
-    const float w = (drawData.d00 * d21 - drawData.d01 * d20) / denom;
-    const float u = 1.0f - v - w;
+    if (shading.model == ShadingModel::PER_PIXEL) {
+        normalizeBatch(batch.normal, batch.count);
+    }
+
+    for (size_t i = 0; i < batch.count; ++i) {
+        const float3 light = shading.model == ShadingModel::PER_VERTEX
+                                 ? batch.light.get(i)
+                                 : fmadd(shading.ambient, batch.ao[i],
+                                         _computeLight(batch.normal.get(i), batch.pos.get(i),
+                                                       shading.lightGrid.lightsAt(batch.screenX[i], screenY),
+                                                       shading));
+        bitMap.setRgbAt(batch.screenX[i], screenY, _applyLightToColor(colors[i], light));
+    }
+
+    batch.count = 0;
+}
+
+template<bool useNormals>
+std::tuple<float, float, float3>
+Texture::_interpolateFromTrianglePoint(const std::array<float, 3> &weights, const Triangle &triangle,
+                                       const ShadingConstants &shading) {
+    const auto [u, v, w] = weights;
 
     const float interpolatedU =
             std::clamp(u * triangle[0].u + v * triangle[1].u + w * triangle[2].u, 0.0f, 1.0f);
     const float interpolatedV =
             std::clamp(u * triangle[0].v + v * triangle[1].v + w * triangle[2].v, 0.0f, 1.0f);
 
-    QVector3D interpolatedNormalVector =
+    float3 interpolatedNormalVector =
             (u * triangle[0].rotatedNormal + v * triangle[1].rotatedNormal + w * triangle[2].rotatedNormal);
 
     if constexpr (useNormals) {
-        const QColor color = m_normalMap->pixelColor(
-            static_cast<int>(interpolatedV * static_cast<float>(m_normalMap->width() - 1)),
-            static_cast<int>((1.0f - interpolatedU) * static_cast<float>(m_normalMap->height() - 1))
-        );
-
-        QVector3D normalFromTexture(
-            (color.red() - 127.0f) / 127.0f,
-            (color.green() - 127.0f) / 127.0f,
-            (color.blue() - 127.0f) / 127.0f
-        );
-        normalFromTexture.normalize();
-
-        QVector3D interpolatedPU = (u * triangle[0].rotatedPuVector +
-                                    v * triangle[1].rotatedPuVector +
-                                    w * triangle[2].rotatedPuVector);
-        interpolatedPU.normalize();
-
-        QVector3D interpolatedPV = (u * triangle[0].rotatedPvVector +
-                                    v * triangle[1].rotatedPvVector +
-                                    w * triangle[2].rotatedPvVector);
-        interpolatedPV.normalize();
-        interpolatedNormalVector.normalize();
-
-        interpolatedNormalVector = QVector3D(
-            interpolatedPU.x() * normalFromTexture.x() +
-            interpolatedPV.x() * normalFromTexture.y() +
-            interpolatedNormalVector.x() * normalFromTexture.z(),
-
-            interpolatedPU.y() * normalFromTexture.x() +
-            interpolatedPV.y() * normalFromTexture.y() +
-            interpolatedNormalVector.y() * normalFromTexture.z(),
-
-            interpolatedPU.z() * normalFromTexture.x() +
-            interpolatedPV.z() * normalFromTexture.y() +
-            interpolatedNormalVector.z() * normalFromTexture.z()
-        );
-
-        interpolatedNormalVector.normalize();
+        /* baked object space normal - only the mesh rotation is left */
+        const float3 objectNormal = shading.normalMap->sampleNearest(interpolatedU, interpolatedV);
+
+        interpolatedNormalVector = shading.normalRotation[0] * objectNormal.x +
+                                   shading.normalRotation[1] * objectNormal.y +
+                                   shading.normalRotation[2] * objectNormal.z;
     }
 
     return {interpolatedU, interpolatedV, interpolatedNormalVector};
@@ -0,0 +1,274 @@
+//
+// Created by Jlisowskyy on 11/12/24.
+//
+
+#ifndef TEXTUREIMAGE_H
+#define TEXTUREIMAGE_H
+
+/* internal includes */
+#include "TexelLayout.h"
+
+/* external includes */
+#include <QImage>
+#include <QRgb>
+#include <QFile>
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/* Screen space derivatives of texture coordinates */
+struct UvGradient {
+    float dudx{};
+    float dvdx{};
+    float dudy{};
+    float dvdy{};
+};
+
+/* Image decoded once at load time into packed texels with full mip pyramid - sampling does not touch Qt at all */
+class TextureImage {
+    // ------------------------------
+    // Class inner types
+    // ------------------------------
+
+    struct _MipLevel {
+        size_t offset;
+        int32_t width;
+        int32_t height;
+
+        /* row-major: texels per row, tiled: tiles per row */
+        int32_t stride;
+
+        /* precomputed (size - 1) factors mapping [0, 1] onto texel indices */
+        float xScale;
+        float yScale;
+    };
+
+    // ------------------------------
+    // Class creation
+    // ------------------------------
+public:
+    /* upper bound of uv pairs passed to a single batched sampling call */
+    static constexpr size_t SAMPLE_BATCH_SIZE = 16;
+
+    explicit TextureImage(const QImage &image, TexelLayout layout = TexelLayout::TILED_4X4);
+
+    ~TextureImage() = default;
+
+    TextureImage(const TextureImage &) = delete;
+
+    TextureImage &operator=(const TextureImage &) = delete;
+
+    // ------------------------------
+    // Class interaction
+    // ------------------------------
+
+    [[nodiscard]] int32_t width() const {
+        return m_levels.front().width;
+    }
+
+    [[nodiscard]] int32_t height() const {
+        return m_levels.front().height;
+    }
+
+    [[nodiscard]] TexelLayout layout() const {
+        return m_layout;
+    }
+
+    [[nodiscard]] size_t levelCount() const {
+        return m_levels.size();
+    }
+
+    [[nodiscard]] QRgb texelAt(const int32_t x, const int32_t y) const {
+        return _texelAt(m_levels.front(), x, y);
+    }
+
+    /* (u, v) in [0, 1], v maps onto image columns and u onto reversed image rows */
+    [[nodiscard]] QRgb sampleNearest(const float u, const float v) const {
+        const _MipLevel &level = m_levels.front();
+        const auto x = static_cast<int32_t>(TexelAddressing::clampCoord(v * level.xScale, level.xScale));
+        const auto y = static_cast<int32_t>(TexelAddressing::clampCoord((1.0f - u) * level.yScale, level.yScale));
+
+        return _texelAt(level, x, y);
+    }
+
+    [[nodiscard]] QRgb sampleBilinear(const float u, const float v) const {
+        return _sampleBilinear(m_levels.front(), u, v);
+    }
+
+    /* Blends bilinear samples of the two mip levels around lod */
+    [[nodiscard]] QRgb sampleTrilinear(float u, float v, float lod) const;
+
+    /* Same as sampleTrilinear for up to SAMPLE_BATCH_SIZE uv pairs sharing lod, bilinear taps are done in SIMD */
+    void sampleTrilinearBatch(const float *u, const float *v, float lod, QRgb *out, size_t count) const;
+
+    /* Mip level matching the texel footprint of a single screen pixel */
+    [[nodiscard]] float computeLod(const UvGradient &gradient) const {
+        return computeTexelLod(gradient, m_levels.front().xScale, m_levels.front().yScale);
+    }
+
+    /* Shared with other texel storages - scales map [0, 1] onto base level texel indices */
+    [[nodiscard]] static float computeTexelLod(const UvGradient &gradient, float xScale, float yScale);
+
+    [[nodiscard]] static QRgb blendBilinear(const QRgb c0, const QRgb c1, const QRgb c2, const QRgb c3, const float wx,
+                                            const float wy) {
+        return _lerpChannel(c0, c1, c2, c3, wx, wy, 24) |
+               _lerpChannel(c0, c1, c2, c3, wx, wy, 16) |
+               _lerpChannel(c0, c1, c2, c3, wx, wy, 8) |
+               _lerpChannel(c0, c1, c2, c3, wx, wy, 0);
+    }
+
+    // ------------------------------
+    // Class protected methods
+    // ------------------------------
+protected:
+    friend class TextureCache;
+
+    /* storage is filled by TextureCache */
+    TextureImage() = default;
+
+    void _buildMipPyramid();
+
+    /* appends storage for a new level, returns its descriptor */
+    _MipLevel _allocateLevel(int32_t width, int32_t height);
+
+    [[nodiscard]] size_t _texelIndex(const _MipLevel &level, const int32_t x, const int32_t y) const {
+        return level.offset + TexelAddressing::index(m_layout, level.stride, x, y);
+    }
+
+    [[nodiscard]] QRgb _texelAt(const _MipLevel &level, const int32_t x, const int32_t y) const {
+        return m_data[_texelIndex(level, x, y)];
+    }
+
+    [[nodiscard]] QRgb _sampleBilinear(const _MipLevel &level, float u, float v) const;
+
+    /* 8 lanes at once on AVX2 - 4 gathers per lane group, remaining pairs go through _sampleBilinear */
+    void _sampleBilinearBatch(const _MipLevel &level, const float *u, const float *v, QRgb *out, size_t count) const;
+
+    static uint32_t _lerpChannel(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, float wx, float wy,
+                                 uint32_t shift) {
+        const float top = static_cast<float>((c0 >> shift) & 0xFF) * (1.0f - wx) +
+                          static_cast<float>((c1 >> shift) & 0xFF) * wx;
+        const float bottom = static_cast<float>((c2 >> shift) & 0xFF) * (1.0f - wx) +
+                             static_cast<float>((c3 >> shift) & 0xFF) * wx;
+
+        return static_cast<uint32_t>(top * (1.0f - wy) + bottom * wy + 0.5f) << shift;
+    }
+
+#ifdef __AVX2__
+    /* TexelAddressing::index for 8 lanes */
+    static __m256i _texelIndex8(TexelLayout layout, __m256i stride, __m256i x, __m256i y);
+
+    /* single 8 bit channel of 8 texel quads, same math as _lerpChannel */
+    static __m256i _lerpChannel8(__m256i c0, __m256i c1, __m256i c2, __m256i c3, __m256 wx, __m256 wy, int shift);
+#endif
+
+    static QRgb _lerpColor(const QRgb c0, const QRgb c1, const float w) {
+        return _lerpChannel(c0, c1, c0, c1, w, 0.0f, 24) |
+               _lerpChannel(c0, c1, c0, c1, w, 0.0f, 16) |
+               _lerpChannel(c0, c1, c0, c1, w, 0.0f, 8) |
+               _lerpChannel(c0, c1, c0, c1, w, 0.0f, 0);
+    }
+
+    // ------------------------------
+    // Class fields
+    // ------------------------------
+
+    TexelLayout m_layout{};
+
+    /* all mip levels stored one after another, level 0 first */
+    std::vector<_MipLevel> m_levels{};
+
+    /* texels are either owned or mapped straight from the cache file */
+    const QRgb *m_data{};
+    std::vector<QRgb> m_texels{};
+    std::unique_ptr<QFile> m_mappedFile{};
+};
+
+inline QRgb TextureImage::_sampleBilinear(const _MipLevel &level, const float u, const float v) const {
+    /* same clamping as the AVX2 lanes */
+    const float fx = TexelAddressing::clampCoord(v * level.xScale, level.xScale);
+    const float fy = TexelAddressing::clampCoord((1.0f - u) * level.yScale, level.yScale);
+
+    const auto x0 = static_cast<int32_t>(fx);
+    const auto y0 = static_cast<int32_t>(fy);
+    const int32_t x1 = x0 + 1 < level.width ? x0 + 1 : x0;
+    const int32_t y1 = y0 + 1 < level.height ? y0 + 1 : y0;
+
+    const float wx = fx - static_cast<float>(x0);
+    const float wy = fy - static_cast<float>(y0);
+
+    return blendBilinear(_texelAt(level, x0, y0), _texelAt(level, x1, y0), _texelAt(level, x0, y1),
+                         _texelAt(level, x1, y1), wx, wy);
+}
+
+inline QRgb TextureImage::sampleTrilinear(const float u, const float v, const float lod) const {
+    /* magnification - NaN lod falls here as well */
+    if (!(lod > 0.0f)) {
+        return _sampleBilinear(m_levels.front(), u, v);
+    }
+
+    const auto maxLevel = static_cast<float>(m_levels.size() - 1);
+    if (lod >= maxLevel) {
+        return _sampleBilinear(m_levels.back(), u, v);
+    }
+
+    const auto level = static_cast<size_t>(lod);
+    const float weight = lod - static_cast<float>(level);
+
+    return _lerpColor(_sampleBilinear(m_levels[level], u, v), _sampleBilinear(m_levels[level + 1], u, v), weight);
+}
+
+inline float TextureImage::computeTexelLod(const UvGradient &gradient, const float xScale, const float yScale) {
+    const float dxdx = gradient.dvdx * xScale;
+    const float dydx = gradient.dudx * yScale;
+    const float dxdy = gradient.dvdy * xScale;
+    const float dydy = gradient.dudy * yScale;
+
+    const float rho2 = std::max(dxdx * dxdx + dydx * dydx, dxdy * dxdy + dydy * dydy);
+
+    /* log2(sqrt(rho2)) */
+    return 0.5f * std::log2(rho2);
+}
+
+/* Color getters used by the rasterizer - lod is selected once per triangle */
+struct TextureColorGetter {
+    const TextureImage *image;
+
+    [[nodiscard]] float computeLod(const UvGradient &gradient) const {
+        return image->computeLod(gradient);
+    }
+
+    [[nodiscard]] QRgb operator()(const float u, const float v, const float lod) const {
+        return image->sampleTrilinear(u, v, lod);
+    }
+
+    void sampleBatch(const float *u, const float *v, const float lod, QRgb *out, const size_t count) const {
+        image->sampleTrilinearBatch(u, v, lod, out, count);
+    }
+};
+
+struct PlainColorGetter {
+    QRgb color;
+
+    [[nodiscard]] float computeLod([[maybe_unused]] const UvGradient &gradient) const {
+        return 0.0f;
+    }
+
+    [[nodiscard]] QRgb operator()([[maybe_unused]] const float u, [[maybe_unused]] const float v,
+                                  [[maybe_unused]] const float lod) const {
+        return color;
+    }
+
+    void sampleBatch([[maybe_unused]] const float *u, [[maybe_unused]] const float *v,
+                     [[maybe_unused]] const float lod, QRgb *out, const size_t count) const {
+        std::fill_n(out, count, color);
+    }
+};
+
+#endif //TEXTUREIMAGE_H
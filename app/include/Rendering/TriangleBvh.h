@@ -0,0 +1,74 @@
+//
+// Created by Jlisowskyy on 11/16/24.
+//
+
+#ifndef TRIANGLEBVH_H
+#define TRIANGLEBVH_H
+
+/* internal includes */
+#include "../Intf.h"
+
+/* external includes */
+#include <cinttypes>
+#include <vector>
+
+/* Bounding volume hierarchy over the object space triangles of a mesh - answers any-hit ray queries only, which is
+ * all ambient occlusion needs */
+class TriangleBvh {
+    // ------------------------------
+    // Class creation
+    // ------------------------------
+public:
+    /* uses positions before rotation */
+    explicit TriangleBvh(const MeshArr &triangles);
+
+    ~TriangleBvh() = default;
+
+    // ------------------------------
+    // Class interaction
+    // ------------------------------
+
+    /* whether anything is hit along origin + t * direction for t in (0, maxDistance] */
+    [[nodiscard]] bool isOccluded(const float3 &origin, const float3 &direction, float maxDistance) const;
+
+    // ------------------------------
+    // Class protected methods
+    // ------------------------------
+protected:
+    struct _Node {
+        float3 boundsMin;
+        float3 boundsMax;
+
+        /* leaf when count > 0: triangles [first, first + count), otherwise children are idx + 1 and first */
+        uint32_t first;
+        uint32_t count;
+    };
+
+    /* precomputed for Moller-Trumbore test */
+    struct _Triangle {
+        float3 v0;
+        float3 edge1;
+        float3 edge2;
+    };
+
+    uint32_t _build(uint32_t begin, uint32_t end);
+
+    [[nodiscard]] static bool _isBoxHit(const _Node &node, const float3 &origin, const float3 &invDirection,
+                                        float maxDistance);
+
+    [[nodiscard]] static bool _isTriangleHit(const _Triangle &triangle, const float3 &origin,
+                                             const float3 &direction, float maxDistance);
+
+    // ------------------------------
+    // Class fields
+    // ------------------------------
+
+    static constexpr uint32_t MAX_LEAF_SIZE = 4;
+    static constexpr size_t MAX_DEPTH = 64;
+
+    std::vector<_Node> m_nodes{};
+    std::vector<_Triangle> m_triangles{};
+    std::vector<float3> m_centroids{};
+};
+
+#endif //TRIANGLEBVH_H
@@ -0,0 +1,166 @@
+//
+// Created by Jlisowskyy on 11/14/24.
+//
+
+#ifndef VIRTUALTEXTURE_H
+#define VIRTUALTEXTURE_H
+
+/* internal includes */
+#include "../Intf.h"
+#include "TextureImage.h"
+
+/* external includes */
+#include <QObject>
+#include <QString>
+#include <QSize>
+#include <QRgb>
+#include <QFuture>
+#include <atomic>
+#include <cinttypes>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/* Texture streamed from its source file in tiles. Tiles of the virtual mip chain are decoded lazily on the global
+ * thread pool when the sampler first touches them and kept in a bounded LRU set. Until a tile arrives sampling falls
+ * back to the nearest resident coarser level - the coarsest level is a single tile which is always resident.
+ *
+ * Sampling is lock free and may run on many threads. update() publishes finished tiles, evicts and issues new loads,
+ * it must be called from the GUI thread while no sampling is in progress. */
+class VirtualTexture : public QObject {
+    Q_OBJECT
+
+    // ------------------------------
+    // Class inner types
+    // ------------------------------
+
+    /* tile texels surrounded with 1 texel border so bilinear filtering never crosses tiles */
+    struct _Tile {
+        int32_t stride;
+        std::vector<QRgb> texels;
+
+        [[nodiscard]] QRgb texelAt(const int32_t x, const int32_t y) const {
+            return texels[static_cast<size_t>(y + 1) * stride + x + 1];
+        }
+    };
+
+    struct _PageEntry {
+        std::atomic<const _Tile *> tile{};
+        std::atomic<bool> isRequested{};
+        std::atomic<uint32_t> lastUsedFrame{};
+        bool isLoading{};
+    };
+
+    struct _Level {
+        int32_t width;
+        int32_t height;
+        int32_t tilesX;
+        int32_t tilesY;
+        float xScale;
+        float yScale;
+        std::unique_ptr<_PageEntry[]> pages;
+    };
+
+    struct _TileKey {
+        int32_t level;
+        int32_t tileX;
+        int32_t tileY;
+    };
+
+    // ------------------------------
+    // Class creation
+    // ------------------------------
+public:
+    /* decodes the coarsest level synchronously - expected to be constructed off the GUI thread */
+    VirtualTexture(const QString &path, const QSize &size);
+
+    ~VirtualTexture() override;
+
+    // ------------------------------
+    // Class interaction
+    // ------------------------------
+
+    [[nodiscard]] bool isValid() const {
+        return !m_levels.empty();
+    }
+
+    [[nodiscard]] int32_t width() const {
+        return m_levels.front().width;
+    }
+
+    [[nodiscard]] int32_t height() const {
+        return m_levels.front().height;
+    }
+
+    [[nodiscard]] float computeLod(const UvGradient &gradient) const;
+
+    /* bilinear sample from the finest resident level not finer than lod */
+    [[nodiscard]] QRgb sample(float u, float v, float lod) const;
+
+    void update();
+
+    // ------------------------------
+    // Class signals
+    // ------------------------------
+signals:
+    /* emitted from worker threads - finer data is available after next update() */
+    void tilesArrived();
+
+    // ------------------------------
+    // Class protected methods
+    // ------------------------------
+protected:
+    [[nodiscard]] _PageEntry &_pageAt(const _TileKey &key) const {
+        const _Level &level = m_levels[key.level];
+        return level.pages[static_cast<size_t>(key.tileY) * level.tilesX + key.tileX];
+    }
+
+    [[nodiscard]] std::unique_ptr<_Tile> _decodeTile(const _TileKey &key) const;
+
+    void _publishTiles();
+
+    void _evictTiles();
+
+    void _requestTiles();
+
+    // ------------------------------
+    // Class fields
+    // ------------------------------
+
+    static constexpr int32_t TILE_SIZE = RESOURCE_CONSTANTS::VIRTUAL_TEXTURE_TILE_SIZE;
+    static_assert((TILE_SIZE & (TILE_SIZE - 1)) == 0);
+
+    QString m_path{};
+    std::vector<_Level> m_levels{};
+
+    /* owned tiles, each published in exactly one page entry */
+    std::vector<std::pair<_TileKey, std::unique_ptr<_Tile> > > m_residentTiles{};
+    uint32_t m_frame{};
+
+    std::mutex m_completedMutex{};
+    std::vector<std::pair<_TileKey, std::unique_ptr<_Tile> > > m_completedTiles{};
+    std::vector<QFuture<void> > m_pendingLoads{};
+    std::atomic<bool> m_isShuttingDown{};
+};
+
+/* Color getter streaming from VirtualTexture */
+struct VirtualTextureColorGetter {
+    const VirtualTexture *texture;
+
+    [[nodiscard]] float computeLod(const UvGradient &gradient) const {
+        return texture->computeLod(gradient);
+    }
+
+    [[nodiscard]] QRgb operator()(const float u, const float v, const float lod) const {
+        return texture->sample(u, v, lod);
+    }
+
+    /* tiles are resolved per texel - no batched path */
+    void sampleBatch(const float *u, const float *v, const float lod, QRgb *out, const size_t count) const {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = texture->sample(u[i], v[i], lod);
+        }
+    }
+};
+
+#endif //VIRTUALTEXTURE_H
@@ -60,10 +60,13 @@ public:
     DoubleSlider *m_alphaSlider{};
     DoubleSlider *m_betaSlider{};
     DoubleSlider *m_deltaSlider{};
+    DoubleSlider *m_kaSlider{};
     DoubleSlider *m_ksSlider{};
     DoubleSlider *m_kdSlider{};
     DoubleSlider *m_mSlider{};
     DoubleSlider *m_lightningPositionSlider{};
+    DoubleSlider *m_lightCountSlider{};
+    DoubleSlider *m_threadCountSlider{};
     DoubleSlider *m_observerDistanceSlider{};
 
     /* Buttons */
@@ -72,8 +75,12 @@ public:
     QAction *m_loadTextureButton{};
     QAction *m_enableTextureButton{};
     QAction *m_loadNormalVectorsButton{};
+    QAction *m_loadHeightMapButton{};
     QAction *m_enableNormalVectorsButton{};
+    QAction *m_perVertexLightingButton{};
+    QAction *m_perVertexPreviewButton{};
     QAction *m_stopLightMovementButton{};
+    QAction *m_enableShadowsButton{};
     QAction *m_changePlainColorButton{};
     QAction *m_changeLightColorButton{};
 
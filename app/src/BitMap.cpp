@@ -4,9 +4,11 @@
 
 /* internal includes */
 #include "../include/Rendering/BitMap.h"
+#include "../include/ManagingObjects/ThreadPool.h"
 
 /* external includes */
 #include <memory>
+#include <algorithm>
 #include <QPainter>
 #include <QPen>
 #include <QColor>
@@ -18,7 +20,8 @@ BitMap::BitMap(const int32_t width, const int32_t height): m_redMap(static_cast<
                                                            m_blueMap(static_cast<_baseTypeT *>(malloc(
                                                                sizeof(_baseTypeT) * width * height))),
                                                            m_width(width),
-                                                           m_height(height) {
+                                                           m_height(height),
+                                                           m_capacity(static_cast<size_t>(width) * height) {
 }
 
 BitMap::~BitMap() {
@@ -27,6 +30,27 @@ BitMap::~BitMap() {
     free(m_blueMap);
 }
 
+void BitMap::resize(const int32_t width, const int32_t height) {
+    const size_t required = static_cast<size_t>(width) * static_cast<size_t>(height);
+
+    if (required > m_capacity) {
+        /* geometric growth - window enlarged in small steps does not reallocate on every frame */
+        const size_t capacity = std::max(required, m_capacity + m_capacity / 2);
+
+        free(m_redMap);
+        free(m_greenMap);
+        free(m_blueMap);
+
+        m_redMap = static_cast<_baseTypeT *>(malloc(sizeof(_baseTypeT) * capacity));
+        m_greenMap = static_cast<_baseTypeT *>(malloc(sizeof(_baseTypeT) * capacity));
+        m_blueMap = static_cast<_baseTypeT *>(malloc(sizeof(_baseTypeT) * capacity));
+        m_capacity = capacity;
+    }
+
+    m_width = width;
+    m_height = height;
+}
+
 void BitMap::setWhiteAll() {
     for (size_t i = 0; i < m_width * m_height; i++) {
         m_redMap[i] = m_greenMap[i] = m_blueMap[i] = 255;
@@ -35,15 +59,25 @@ void BitMap::setWhiteAll() {
 
 void BitMap::dropToPixMap(QPixmap &pixMap) const {
     const QImage image = createQImage();
-    pixMap = QPixmap::fromImage(image);
+
+    if (pixMap.isNull() || (pixMap.width() == m_width && pixMap.height() == m_height)) {
+        pixMap = QPixmap::fromImage(image);
+        return;
+    }
+
+    /* bitmap rendered in lower resolution - stretch it over the target */
+    pixMap = QPixmap::fromImage(image.scaled(pixMap.width(), pixMap.height(), Qt::IgnoreAspectRatio,
+                                             Qt::FastTransformation));
 }
 
 QImage BitMap::createQImage() const {
     QImage image(m_width, m_height, QImage::Format_RGB32);
 
-    #pragma omp parallel for schedule(static)
-    for (int32_t y = 0; y < m_height; y++) {
+    static constexpr size_t ROWS_PER_TASK = 8;
+    ThreadPool::getInstance().parallelFor(0, m_height, ROWS_PER_TASK, [&](const size_t row) {
+        const auto y = static_cast<int32_t>(row);
         uchar *line = image.scanLine(y);
+
         for (int32_t x = 0; x < m_width; x++) {
             const size_t pixelIndex = _atCord(x, y, m_width);
             const size_t lineIndex = x * 4;
@@ -53,7 +87,7 @@ QImage BitMap::createQImage() const {
             line[lineIndex + 2] = static_cast<uchar>(m_redMap[pixelIndex]);
             line[lineIndex + 3] = 255;
         }
-    }
+    });
 
     return image;
 }
@@ -12,9 +12,11 @@
 #include <QVector3D>
 #include <ranges>
 #include <QPixmap>
+#include <QTransform>
 
 DrawingWidget::DrawingWidget(QWidget *parent) : QGraphicsView(parent),
                                                 m_scene(new QGraphicsScene(this)),
+                                                m_resizeTimer(new QTimer(this)),
                                                 m_observerDistance(VIEW_SETTINGS::DEFAULT_OBSERVER_DISTANCE) {
     Q_ASSERT(parent != nullptr);
     setScene(m_scene);
@@ -29,29 +31,84 @@ DrawingWidget::DrawingWidget(QWidget *parent) : QGraphicsView(parent),
     setRenderHint(QPainter::Antialiasing, true);
     setTransformationAnchor(AnchorViewCenter);
 
+    m_resizeTimer->setSingleShot(true);
+    m_resizeTimer->setInterval(UI_CONSTANTS::RESIZE_DEBOUNCE_MS);
+    connect(m_resizeTimer, &QTimer::timeout, this, &DrawingWidget::_onResizeSettled);
+
+    m_pixMapItem = m_scene->addPixmap(m_pixMap);
+    m_pixMapItem->setZValue(-1);
+    _createNetItems();
+
     updateScene();
 }
 
-DrawingWidget::~DrawingWidget() {
-    clearContent();
+DrawingWidget::~DrawingWidget() = default;
+
+void DrawingWidget::_createNetItems() {
+    for (size_t idx = 0; idx < m_pointItems.size(); ++idx) {
+        auto *pointItem = new BezierPoint3DItem({}, BEZIER_CONSTANTS::DEFAULT_POINT_RADIUS, idx);
+        m_scene->addItem(pointItem);
+        pointItem->setZValue(2);
+        pointItem->setVisible(false);
+        m_pointItems[idx] = pointItem;
+    }
+
+    QPen pen(UI_CONSTANTS::DEFAULT_BEZIER_LINE_COLOR);
+    pen.setWidth(3);
+
+    for (auto &lineItem: m_lineItems) {
+        lineItem = m_scene->addLine(0, 0, 0, 0, pen);
+        lineItem->setZValue(1);
+        lineItem->setVisible(false);
+    }
 }
 
-void DrawingWidget::clearContent() {
-    m_scene->clear();
-    m_points.clear();
-    m_lines.clear();
+void DrawingWidget::setBezierPoint(const size_t idx, const QVector3D &point) {
+    Q_ASSERT(idx < m_pointItems.size());
+
+    m_pointItems[idx]->set3DPoint(point);
+    m_pointItems[idx]->setPos(dropPointToScreen(point));
 }
 
-void DrawingWidget::drawBezierPoint(const QVector3D &point) {
-    m_points.push_back(point);
+void DrawingWidget::setBezierLine(const size_t idx, const QVector3D &start, const QVector3D &end) {
+    Q_ASSERT(idx < m_lineItems.size());
+
+    const auto startPoint = dropPointToScreen(start);
+    const auto endPoint = dropPointToScreen(end);
+    m_lineItems[idx]->setLine(startPoint.x(), startPoint.y(), endPoint.x(), endPoint.y());
 }
 
-void DrawingWidget::drawBezierLine(const QVector3D &start, const QVector3D &end) {
-    m_lines.emplace_back(start, end);
+void DrawingWidget::setNetVisible(const bool isVisible) {
+    for (auto *pointItem: m_pointItems) {
+        pointItem->setVisible(isVisible);
+    }
+
+    for (auto *lineItem: m_lineItems) {
+        lineItem->setVisible(isVisible);
+    }
 }
 
 void DrawingWidget::resizeEvent(QResizeEvent *event) {
     QGraphicsView::resizeEvent(event);
+
+    if (m_width <= 0.0f || m_height <= 0.0f) {
+        updateScene();
+        return;
+    }
+
+    /* stretch the last frame instead of rendering a new one for every intermediate size */
+    const QRectF viewRect = rect();
+    const auto width = static_cast<float>(viewRect.width());
+    const auto height = static_cast<float>(viewRect.height());
+
+    setSceneRect(-width / 2, -height / 2, width, height);
+    m_pixMapItem->setTransform(QTransform::fromScale(width / m_width, height / m_height));
+    m_pixMapItem->setPos(QPointF(-width / 2, -height / 2));
+
+    m_resizeTimer->start();
+}
+
+void DrawingWidget::_onResizeSettled() {
     updateScene();
 }
 
@@ -65,33 +122,20 @@ void DrawingWidget::updateScene() {
 }
 
 void DrawingWidget::updateElements() {
-    m_scene->clear();
-    m_pixMap = new QPixmap(static_cast<int>(m_width), static_cast<int>(m_height));
-
-    size_t idx = 0;
-    for (const auto &point: m_points) {
-        _drawBezierPoint(point, idx++);
+    if (const QSize size(static_cast<int>(m_width), static_cast<int>(m_height)); m_pixMap.size() != size) {
+        /* scaled last frame is displayed until the new one is rendered */
+        m_pixMap = m_pixMap.isNull()
+                       ? QPixmap(size)
+                       : m_pixMap.scaled(size, Qt::IgnoreAspectRatio, Qt::FastTransformation);
     }
 
-    for (const auto &line: m_lines) {
-        _drawBezierLine(line);
-    }
-
-    const auto pMapItem = m_scene->addPixmap(*m_pixMap);
-    pMapItem->setZValue(-1);
-    pMapItem->setPos(QPointF(-m_width / 2, -m_height / 2));
-    m_pixMapItem = pMapItem;
+    m_pixMapItem->resetTransform();
+    m_pixMapItem->setPixmap(m_pixMap);
+    m_pixMapItem->setPos(QPointF(-m_width / 2, -m_height / 2));
 
     emit onElementsUpdate(this);
 }
 
-void DrawingWidget::_drawBezierPoint(const QVector3D &point, const size_t idx) const {
-    auto *pointItem = new BezierPoint3DItem(point, BEZIER_CONSTANTS::DEFAULT_POINT_RADIUS, idx);
-    m_scene->addItem(pointItem);
-    pointItem->setPos(dropPointToScreen(point));
-    pointItem->setZValue(2);
-}
-
 void DrawingWidget::setObserverDistance(const double distance) {
     m_observerDistance = distance;
     updateScene();
@@ -101,17 +145,6 @@ void DrawingWidget::setPixmap(const QPixmap *pixmap) const {
     m_pixMapItem->setPixmap(*pixmap);
 }
 
-void DrawingWidget::_drawBezierLine(const std::pair<QVector3D, QVector3D> &line) const {
-    const auto start = dropPointToScreen(line.first);
-    const auto end = dropPointToScreen(line.second);
-    const auto pLine = m_scene->addLine(start.x(), start.y(), end.x(), end.y());
-
-    pLine->setZValue(1);
-    QPen pen(UI_CONSTANTS::DEFAULT_BEZIER_LINE_COLOR);
-    pen.setWidth(3);
-    pLine->setPen(pen);
-}
-
 QPointF DrawingWidget::dropPointToScreen(const QVector3D &point) const {
     //    const double z = point.z() + m_observerDistance;
     //    const double projX = (point.x() * m_observerDistance / z);
@@ -122,17 +155,6 @@ QPointF DrawingWidget::dropPointToScreen(const QVector3D &point) const {
     return {point.x(), point.y()};
 }
 
-void DrawingWidget::_drawTriangleLine(const std::pair<QVector3D, QVector3D> &line) const {
-    const auto start = dropPointToScreen(line.first);
-    const auto end = dropPointToScreen(line.second);
-    const auto pLine = m_scene->addLine(start.x(), start.y(), end.x(), end.y());
-
-    pLine->setZValue(0);
-    auto pen = QPen(UI_CONSTANTS::DEFAULT_TRIANGLE_LINE_COLOR);
-    pen.setWidth(1);
-    pLine->setPen(pen);
-}
-
 // void DrawingWidget::_drawTexture() {
 //     m_pixMap->fill(Qt::white);
 //
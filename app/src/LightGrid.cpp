@@ -0,0 +1,145 @@
+//
+// Created by Jlisowskyy on 11/14/24.
+//
+
+/* internal includes */
+#include "../include/Rendering/LightGrid.h"
+
+/* external includes */
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <unordered_map>
+
+void LightGrid::build(const LightSet &lights, const MeshArr &triangles, const int32_t width, const int32_t height) {
+    static_assert(LIGHTING_CONSTANTS::MAX_LIGHT_COUNT <= 64, "Light masks are stored in 64 bits");
+    Q_ASSERT(lights.size() <= LIGHTING_CONSTANTS::MAX_LIGHT_COUNT);
+
+    m_tilesX = std::max(1, (width + TILE_SIZE - 1) >> TILE_SHIFT);
+    m_tilesY = std::max(1, (height + TILE_SIZE - 1) >> TILE_SHIFT);
+
+    /* tiles reached by every light share the first set */
+    m_tileSets.assign(1, lights);
+    m_tileSetIdx.assign(static_cast<size_t>(m_tilesX) * m_tilesY, 0);
+
+    /* cone term drops below the threshold outside of this angle, point lights reach everything */
+    std::vector<float> cosCutoff(lights.size(), -1.0f);
+    bool hasSpotLights = false;
+
+    for (size_t i = 0; i < lights.size(); ++i) {
+        if (const float exponent = lights.coneExponent()[i]; exponent > 0.0f) {
+            cosCutoff[i] = std::pow(LIGHTING_CONSTANTS::LIGHT_CULL_THRESHOLD, 1.0f / exponent);
+            hasSpotLights = true;
+        }
+    }
+
+    if (!hasSpotLights) {
+        return;
+    }
+
+    _computeTileDepths(triangles, width, height);
+
+    const uint64_t allMask = lights.size() == 64 ? ~uint64_t{0} : (uint64_t{1} << lights.size()) - 1;
+    std::unordered_map<uint64_t, uint32_t> setByMask{{allMask, 0}};
+
+    const int32_t halfWidth = width / 2;
+    const int32_t halfHeight = height / 2;
+    static constexpr float HALF_TILE = 0.5f * static_cast<float>(TILE_SIZE);
+
+    for (int32_t ty = 0; ty < m_tilesY; ++ty) {
+        for (int32_t tx = 0; tx < m_tilesX; ++tx) {
+            const size_t tileIdx = static_cast<size_t>(ty) * m_tilesX + tx;
+            const _TileBounds &bounds = m_tileBounds[tileIdx];
+
+            uint64_t mask = 0;
+
+            /* tiles without geometry are never shaded */
+            if (bounds.minZ <= bounds.maxZ) {
+                const float3 center(
+                    static_cast<float>((tx << TILE_SHIFT) - halfWidth) + HALF_TILE,
+                    static_cast<float>((ty << TILE_SHIFT) - halfHeight) + HALF_TILE,
+                    0.5f * (bounds.minZ + bounds.maxZ)
+                );
+
+                const float halfDepth = 0.5f * (bounds.maxZ - bounds.minZ);
+                const float radius = std::sqrt(2.0f * HALF_TILE * HALF_TILE + halfDepth * halfDepth);
+
+                for (size_t i = 0; i < lights.size(); ++i) {
+                    const bool isReaching = cosCutoff[i] < 0.0f || _isConeTouchingSphere(
+                                                float3(lights.posX()[i], lights.posY()[i], lights.posZ()[i]),
+                                                float3(lights.dirX()[i], lights.dirY()[i], lights.dirZ()[i]),
+                                                cosCutoff[i], center, radius);
+
+                    mask |= static_cast<uint64_t>(isReaching) << i;
+                }
+            }
+
+            const auto [it, isInserted] = setByMask.try_emplace(mask, static_cast<uint32_t>(m_tileSets.size()));
+            if (isInserted) {
+                LightSet tileSet{};
+
+                for (size_t i = 0; i < lights.size(); ++i) {
+                    if (mask & (uint64_t{1} << i)) {
+                        tileSet.addLight(lights.lightAt(i));
+                    }
+                }
+
+                m_tileSets.push_back(std::move(tileSet));
+            }
+
+            m_tileSetIdx[tileIdx] = it->second;
+        }
+    }
+}
+
+void LightGrid::_computeTileDepths(const MeshArr &triangles, const int32_t width, const int32_t height) {
+    m_tileBounds.assign(static_cast<size_t>(m_tilesX) * m_tilesY, {FLT_MAX, -FLT_MAX});
+
+    const int32_t halfWidth = width / 2;
+    const int32_t halfHeight = height / 2;
+
+    for (const auto &triangle: triangles) {
+        float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+        float maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
+
+        for (const auto &vertex: triangle) {
+            const float3 &p = vertex.rotatedPosition;
+
+            minX = std::min(minX, p.x);
+            minY = std::min(minY, p.y);
+            minZ = std::min(minZ, p.z);
+            maxX = std::max(maxX, p.x);
+            maxY = std::max(maxY, p.y);
+            maxZ = std::max(maxZ, p.z);
+        }
+
+        /* one pixel margin - span ends are rounded outwards by the rasterizer */
+        const int32_t x0 = std::clamp(static_cast<int32_t>(std::floor(minX)) - 1 + halfWidth, 0, width - 1);
+        const int32_t x1 = std::clamp(static_cast<int32_t>(std::ceil(maxX)) + 1 + halfWidth, 0, width - 1);
+        const int32_t y0 = std::clamp(static_cast<int32_t>(std::floor(minY)) - 1 + halfHeight, 0, height - 1);
+        const int32_t y1 = std::clamp(static_cast<int32_t>(std::ceil(maxY)) + 1 + halfHeight, 0, height - 1);
+
+        for (int32_t ty = y0 >> TILE_SHIFT; ty <= y1 >> TILE_SHIFT; ++ty) {
+            for (int32_t tx = x0 >> TILE_SHIFT; tx <= x1 >> TILE_SHIFT; ++tx) {
+                _TileBounds &bounds = m_tileBounds[static_cast<size_t>(ty) * m_tilesX + tx];
+
+                bounds.minZ = std::min(bounds.minZ, minZ);
+                bounds.maxZ = std::max(bounds.maxZ, maxZ);
+            }
+        }
+    }
+}
+
+bool LightGrid::_isConeTouchingSphere(const float3 &apex, const float3 &axis, const float cosAngle,
+                                      const float3 &center, const float radius) {
+    const float3 v = center - apex;
+    const float lengthSq = dot(v, v);
+    const float alongAxis = dot(v, axis);
+    const float sinAngle = std::sqrt(std::max(0.0f, 1.0f - cosAngle * cosAngle));
+
+    /* distance from the sphere center to the cone surface, cone is narrower than a half-space */
+    const float distance = cosAngle * std::sqrt(std::max(0.0f, lengthSq - alongAxis * alongAxis)) -
+                           alongAxis * sinAngle;
+
+    return distance <= radius && alongAxis >= -radius;
+}
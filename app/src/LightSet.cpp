@@ -0,0 +1,50 @@
+//
+// Created by Jlisowskyy on 11/14/24.
+//
+
+/* internal includes */
+#include "../include/Rendering/LightSet.h"
+
+void LightSet::addLight(const Light &light) {
+    m_posX.push_back(light.position.x);
+    m_posY.push_back(light.position.y);
+    m_posZ.push_back(light.position.z);
+
+    m_diffuseR.push_back(light.diffuse.x);
+    m_diffuseG.push_back(light.diffuse.y);
+    m_diffuseB.push_back(light.diffuse.z);
+
+    m_specularR.push_back(light.specular.x);
+    m_specularG.push_back(light.specular.y);
+    m_specularB.push_back(light.specular.z);
+
+    m_dirX.push_back(light.direction.x);
+    m_dirY.push_back(light.direction.y);
+    m_dirZ.push_back(light.direction.z);
+
+    m_coneExponent.push_back(light.coneExponent);
+
+    m_shadowMap.push_back(light.shadowMap);
+}
+
+LightSet::Light LightSet::lightAt(const size_t idx) const {
+    return {
+        {m_posX[idx], m_posY[idx], m_posZ[idx]},
+        {m_diffuseR[idx], m_diffuseG[idx], m_diffuseB[idx]},
+        {m_specularR[idx], m_specularG[idx], m_specularB[idx]},
+        {m_dirX[idx], m_dirY[idx], m_dirZ[idx]},
+        m_coneExponent[idx],
+        m_shadowMap[idx]
+    };
+}
+
+void LightSet::clear() {
+    for (auto *arr: {
+             &m_posX, &m_posY, &m_posZ, &m_diffuseR, &m_diffuseG, &m_diffuseB, &m_specularR, &m_specularG,
+             &m_specularB, &m_dirX, &m_dirY, &m_dirZ, &m_coneExponent
+         }) {
+        arr->clear();
+    }
+
+    m_shadowMap.clear();
+}
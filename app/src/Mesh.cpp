@@ -5,8 +5,16 @@
 /* Main header */
 #include "../include/Rendering/Mesh.h"
 
+/* internal includes */
+#include "../include/Rendering/TriangleBvh.h"
+#include "../include/ManagingObjects/ThreadPool.h"
+
 /* external includes */
 #include <cmath>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <QDebug>
 
 
 Mesh::Mesh(QObject *parent, const ControlPoints &controlPoints, const float alpha, const float beta, const float delta,
@@ -16,7 +24,8 @@ Mesh::Mesh(QObject *parent, const ControlPoints &controlPoints, const float alph
                                 m_beta(beta),
                                 m_delta(delta),
                                 m_controlPoints(controlPoints),
-                                m_triangles(_interpolateBezier(controlPoints)),
+                                m_triangles(_interpolateBezier(controlPoints, accuracy)),
+                                m_previewTriangles(_interpolateBezier(controlPoints, _getPreviewAccuracy())),
                                 m_figure(_getFigure()) {
 }
 
@@ -37,16 +46,25 @@ void Mesh::setDelta(const double delta) {
 
 void Mesh::setAccuracy(const double accuracy) {
     m_triangleAccuracy = static_cast<int>(accuracy);
-    m_triangles = _interpolateBezier(m_controlPoints);
+    m_triangles = _interpolateBezier(m_controlPoints, m_triangleAccuracy);
+    m_previewTriangles = _interpolateBezier(m_controlPoints, _getPreviewAccuracy());
+    ++m_revision;
 }
 
-MeshArr Mesh::_interpolateBezier(const ControlPoints &controlPoints) const {
-    MeshArr arr{};
+int Mesh::_getPreviewAccuracy() const {
+    return std::min(m_triangleAccuracy, RENDER_CONSTANTS::PREVIEW_TRIANGLE_ACCURACY);
+}
+
+MeshArr Mesh::_interpolateBezier(const ControlPoints &controlPoints, const int accuracy) const {
+    const float step = 1.0f / static_cast<float>(accuracy - 1);
+    const int steps = accuracy;
 
-    const float step = 1.0f / static_cast<float>(m_triangleAccuracy - 1);
-    const int steps = m_triangleAccuracy;
+    /* two triangles per quad, each row writes only its own slots */
+    MeshArr arr(2 * (steps - 1) * (steps - 1));
+
+    ThreadPool::getInstance().parallelFor(0, steps - 1, 1, [&](const size_t row) {
+        const auto i = static_cast<int>(row);
 
-    for (int i = 0; i < steps - 1; ++i) {
         for (int j = 0; j < steps - 1; ++j) {
             const float u = static_cast<float>(i) * step;
             const float v = static_cast<float>(j) * step;
@@ -64,59 +82,156 @@ MeshArr Mesh::_interpolateBezier(const ControlPoints &controlPoints) const {
             const auto [p11, pu11, pv11] = _computePointAndDeriv(controlPoints, bu_next, bv_next, buDeriv_next,
                                                                  bvDeriv_next);
 
-            const QVector3D n00 = QVector3D::crossProduct(pu00, pv00).normalized();
-            const QVector3D n10 = QVector3D::crossProduct(pu10, pv10).normalized();
-            const QVector3D n01 = QVector3D::crossProduct(pu01, pv01).normalized();
-            const QVector3D n11 = QVector3D::crossProduct(pu11, pv11).normalized();
+            /* frames depend on (u, v) only - copies of a point shared by neighbouring cells match exactly */
+            const auto [t00, b00, n00] = computeTangentFrame(pu00, pv00);
+            const auto [t10, b10, n10] = computeTangentFrame(pu10, pv10);
+            const auto [t01, b01, n01] = computeTangentFrame(pu01, pv01);
+            const auto [t11, b11, n11] = computeTangentFrame(pu11, pv11);
 
             Triangle t1, t2;
 
-            t1[0] = Vertex(p00, pu00, pv00, n00, u, v, m_alpha, m_beta, m_delta);
-            t1[1] = Vertex(p10, pu10, pv10, n10, u_next, v, m_alpha, m_beta, m_delta);
-            t1[2] = Vertex(p01, pu01, pv01, n01, u, v_next, m_alpha, m_beta, m_delta);
+            t1[0] = Vertex(p00, t00, b00, n00, u, v, m_alpha, m_beta, m_delta);
+            t1[1] = Vertex(p10, t10, b10, n10, u_next, v, m_alpha, m_beta, m_delta);
+            t1[2] = Vertex(p01, t01, b01, n01, u, v_next, m_alpha, m_beta, m_delta);
+
+            t2[0] = Vertex(p10, t10, b10, n10, u_next, v, m_alpha, m_beta, m_delta);
+            t2[1] = Vertex(p11, t11, b11, n11, u_next, v_next, m_alpha, m_beta, m_delta);
+            t2[2] = Vertex(p01, t01, b01, n01, u, v_next, m_alpha, m_beta, m_delta);
+
+            /* unique points form accuracy x accuracy grid */
+            const auto i00 = static_cast<uint32_t>(i * steps + j);
+            const auto i10 = static_cast<uint32_t>((i + 1) * steps + j);
+            const auto i01 = i00 + 1;
+            const auto i11 = i10 + 1;
+
+            t1[0].index = i00;
+            t1[1].index = i10;
+            t1[2].index = i01;
 
-            t2[0] = Vertex(p10, pu10, pv10, n10, u_next, v, m_alpha, m_beta, m_delta);
-            t2[1] = Vertex(p11, pu11, pv11, n11, u_next, v_next, m_alpha, m_beta, m_delta);
-            t2[2] = Vertex(p01, pu01, pv01, n01, u, v_next, m_alpha, m_beta, m_delta);
+            t2[0].index = i10;
+            t2[1].index = i11;
+            t2[2].index = i01;
 
-            arr.push_back(t1);
-            arr.push_back(t2);
+            const size_t quadIdx = static_cast<size_t>(i) * (steps - 1) + j;
+            arr[2 * quadIdx] = t1;
+            arr[2 * quadIdx + 1] = t2;
         }
-    }
+    });
+
+    _bakeAmbientOcclusion(arr);
 
     return arr;
 }
 
-std::tuple<QVector3D, QVector3D, QVector3D> Mesh::_computePointAndDeriv(
-    const ControlPoints &points,
+void Mesh::_bakeAmbientOcclusion(MeshArr &triangles) {
+    const auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<const Vertex *> uniqueVertices{};
+    float3 boundsMin(FLT_MAX, FLT_MAX, FLT_MAX);
+    float3 boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    for (const auto &triangle: triangles) {
+        for (const auto &vertex: triangle) {
+            if (vertex.index >= uniqueVertices.size()) {
+                uniqueVertices.resize(vertex.index + 1, nullptr);
+            }
+
+            uniqueVertices[vertex.index] = &vertex;
+
+            boundsMin = min(boundsMin, vertex.position);
+            boundsMax = max(boundsMax, vertex.position);
+        }
+    }
+
+    if (uniqueVertices.empty()) {
+        return;
+    }
+
+    const TriangleBvh bvh(triangles);
+    const float diagonal = length(boundsMax - boundsMin);
+    const float maxDistance = LIGHTING_CONSTANTS::AO_DISTANCE_FRACTION * diagonal;
+    /* keeps rays from hitting the triangles they start on */
+    const float rayOffset = 1e-3f * diagonal;
+
+    static constexpr int RAY_COUNT = LIGHTING_CONSTANTS::AO_RAY_COUNT;
+    static constexpr float GOLDEN_ANGLE = 2.39996323f;
+
+    std::vector<float> ao(uniqueVertices.size(), 1.0f);
+
+    /* ray counts vary a lot between open and enclosed vertices - small grain lets idle threads steal the rest */
+    ThreadPool::getInstance().parallelFor(0, uniqueVertices.size(), AO_VERTICES_PER_TASK, [&](const size_t idx) {
+        const Vertex *vertex = uniqueVertices[idx];
+        if (!vertex) {
+            return;
+        }
+
+        const float3 &n = vertex->normal;
+        const float3 &t = vertex->tangent;
+        const float3 &b = vertex->bitangent;
+        const float3 origin = fmadd(n, rayOffset, vertex->position);
+
+        /* neighbouring vertices get rotated patterns - turns banding into noise */
+        const float rotation = GOLDEN_ANGLE * static_cast<float>(idx);
+
+        int openRays = 0;
+        for (int k = 0; k < RAY_COUNT; ++k) {
+            /* cosine weighted Fibonacci spiral over the hemisphere */
+            const float r = std::sqrt((static_cast<float>(k) + 0.5f) / static_cast<float>(RAY_COUNT));
+            const float phi = GOLDEN_ANGLE * static_cast<float>(k) + rotation;
+            const float3 direction = r * std::cos(phi) * t + r * std::sin(phi) * b + std::sqrt(1.0f - r * r) * n;
+
+            openRays += bvh.isOccluded(origin, direction, maxDistance) ? 0 : 1;
+        }
+
+        ao[idx] = static_cast<float>(openRays) / static_cast<float>(RAY_COUNT);
+    });
+
+    for (auto &triangle: triangles) {
+        for (auto &vertex: triangle) {
+            vertex.ao = ao[vertex.index];
+        }
+    }
+
+    const auto t1 = std::chrono::steady_clock::now();
+    qDebug() << "Time spent on baking ambient occlusion: " << (t1 - t0).count() << " ns";
+}
+
+std::tuple<float3, float3, float3> Mesh::_computePointAndDeriv(
+    const ControlPoints &controlPoints,
     const BernsteinTable &bu,
     const BernsteinTable &bv,
     const BernsteinTable &buDeriv,
     const BernsteinTable &bvDeriv
 ) {
-    QVector3D point{};
-    QVector3D derivativeU{};
-    QVector3D derivativeV{};
+    /* control points are the Qt boundary of the surface - everything below stays in float3 */
+    std::array<float3, BEZIER_CONSTANTS::CONTROL_POINTS_COUNT> points{};
+    for (size_t idx = 0; idx < points.size(); ++idx) {
+        points[idx] = float3(controlPoints[idx]);
+    }
+
+    float3 point{};
+    float3 derivativeU{};
+    float3 derivativeV{};
 
     for (int i = 0; i < BEZIER_CONSTANTS::CONTROL_POINTS_DIM; ++i) {
         for (int j = 0; j < BEZIER_CONSTANTS::CONTROL_POINTS_DIM; ++j) {
-            point += points[i * BEZIER_CONSTANTS::CONTROL_POINTS_DIM + j] * (bu[i] * bv[j]);
+            point = fmadd(points[i * BEZIER_CONSTANTS::CONTROL_POINTS_DIM + j], bu[i] * bv[j], point);
         }
     }
 
     for (int i = 0; i < BEZIER_CONSTANTS::CONTROL_POINTS_DIM - 1; ++i) {
         for (int j = 0; j < BEZIER_CONSTANTS::CONTROL_POINTS_DIM; ++j) {
-            const QVector3D &current = points[i * BEZIER_CONSTANTS::CONTROL_POINTS_DIM + j];
-            const QVector3D &next = points[(i + 1) * BEZIER_CONSTANTS::CONTROL_POINTS_DIM + j];
-            derivativeU += (next - current) * (buDeriv[i] * bv[j]);
+            const float3 &current = points[i * BEZIER_CONSTANTS::CONTROL_POINTS_DIM + j];
+            const float3 &next = points[(i + 1) * BEZIER_CONSTANTS::CONTROL_POINTS_DIM + j];
+            derivativeU = fmadd(next - current, buDeriv[i] * bv[j], derivativeU);
         }
     }
 
     for (int i = 0; i < BEZIER_CONSTANTS::CONTROL_POINTS_DIM; ++i) {
         for (int j = 0; j < BEZIER_CONSTANTS::CONTROL_POINTS_DIM - 1; ++j) {
-            const QVector3D &current = points[i * BEZIER_CONSTANTS::CONTROL_POINTS_DIM + j];
-            const QVector3D &next = points[i * BEZIER_CONSTANTS::CONTROL_POINTS_DIM + j + 1];
-            derivativeV += (next - current) * (bu[i] * bvDeriv[j]);
+            const float3 &current = points[i * BEZIER_CONSTANTS::CONTROL_POINTS_DIM + j];
+            const float3 &next = points[i * BEZIER_CONSTANTS::CONTROL_POINTS_DIM + j + 1];
+            derivativeV = fmadd(next - current, bu[i] * bvDeriv[j], derivativeV);
         }
     }
 
@@ -127,17 +242,20 @@ std::tuple<QVector3D, QVector3D, QVector3D> Mesh::_computePointAndDeriv(
 }
 
 void Mesh::_adjustAfterRotation() {
-#pragma omp parallel for
-    for (auto &triangle: m_triangles) {
-        for (auto &vertex: triangle) {
-            vertex.resetRotation();
-            vertex.rotate(m_alpha, m_beta, m_delta);
-        }
+    ++m_revision;
+
+    for (MeshArr *triangles: {&m_triangles, &m_previewTriangles}) {
+        ThreadPool::getInstance().parallelFor(0, triangles->size(), TRIANGLES_PER_TASK, [&](const size_t idx) {
+            for (auto &vertex: (*triangles)[idx]) {
+                vertex.resetRotation();
+                vertex.rotate(m_alpha, m_beta, m_delta);
+            }
+        });
     }
 }
 
 MeshArr Mesh::_getFigure() {
-    static constexpr QVector3D kPoints[5]{
+    static constexpr float3 kPoints[5]{
         {150, 0, 150},
         {150, 0, -150},
         {-150, 0, -150},
@@ -168,20 +286,20 @@ MeshArr Mesh::_getFigure() {
         Triangle triangle{};
 
         for (size_t p_idx = 0; p_idx < 3; ++p_idx) {
-            const QVector3D &p0 = kPoints[kTrianges[t_idx][(p_idx - 1) % 3]];
-            const QVector3D &p1 = kPoints[kTrianges[t_idx][p_idx]];
-            const QVector3D &p2 = kPoints[kTrianges[t_idx][(p_idx + 1) % 3]];
+            const float3 &p0 = kPoints[kTrianges[t_idx][(p_idx - 1) % 3]];
+            const float3 &p1 = kPoints[kTrianges[t_idx][p_idx]];
+            const float3 &p2 = kPoints[kTrianges[t_idx][(p_idx + 1) % 3]];
 
-            QVector3D edge1 = p1 - p0;
-            QVector3D edge2 = p2 - p0;
-            QVector3D normal = QVector3D::crossProduct(edge1, edge2).normalized();
+            float3 edge1 = p1 - p0;
+            float3 edge2 = p2 - p0;
+            float3 normal = normalize(cross(edge1, edge2));
 
             const auto [u, v] = kUvs[kTrianges[t_idx][p_idx]];
 
             triangle[p_idx] = Vertex(
                 kPoints[kTrianges[t_idx][p_idx]],
-                QVector3D(),
-                QVector3D(),
+                float3(),
+                float3(),
                 -normal,
                 u, v, 0, 0, 0
             );
@@ -195,35 +313,75 @@ MeshArr Mesh::_getFigure() {
     return arr;
 }
 
-void Mesh::rotate(QVector3D &p, const float xRotationAngle, const float zRotationAngle, const float yRotationAngle) {
+void Mesh::rotate(float3 &p, const float xRotationAngle, const float zRotationAngle, const float yRotationAngle) {
     const float xRad = xRotationAngle * static_cast<float>(M_PI) / 180.0f;
     const float yRad = yRotationAngle * static_cast<float>(M_PI) / 180.0f;
     const float zRad = zRotationAngle * static_cast<float>(M_PI) / 180.0f;
 
-    float x = p.x();
-    float y = p.y();
-    float z = p.z();
+    /* every step reads the coordinates from before it - keeps lengths and angles, so vertex frames stay
+     * orthonormal after rotation */
+    const float3 xRotated{
+        p.x,
+        p.y * std::cos(xRad) - p.z * std::sin(xRad),
+        p.y * std::sin(xRad) + p.z * std::cos(xRad)
+    };
+
+    const float3 yRotated{
+        xRotated.x * std::cos(yRad) + xRotated.z * std::sin(yRad),
+        xRotated.y,
+        -xRotated.x * std::sin(yRad) + xRotated.z * std::cos(yRad)
+    };
 
-    /* x rotation */
-    y = y * std::cos(xRad) - z * std::sin(xRad);
-    z = y * std::sin(xRad) + z * std::cos(xRad);
+    p = {
+        yRotated.x * std::cos(zRad) - yRotated.y * std::sin(zRad),
+        yRotated.x * std::sin(zRad) + yRotated.y * std::cos(zRad),
+        yRotated.z
+    };
+}
+
+void Mesh::rotate(QVector3D &p, const float xRotationAngle, const float zRotationAngle, const float yRotationAngle) {
+    float3 rotated(p);
+    rotate(rotated, xRotationAngle, zRotationAngle, yRotationAngle);
+    p = rotated.toQt();
+}
+
+std::array<float3, 3> Mesh::getRotationBasis() const {
+    std::array<float3, 3> basis{
+        float3(1.0f, 0.0f, 0.0f),
+        float3(0.0f, 1.0f, 0.0f),
+        float3(0.0f, 0.0f, 1.0f),
+    };
+
+    for (auto &axis: basis) {
+        rotate(axis, m_alpha, m_beta, m_delta);
+    }
+
+    return basis;
+}
+
+std::tuple<float3, float3, float3> Mesh::evaluateSurface(const ControlPoints &controlPoints, const float u,
+                                                         const float v) {
+    const auto [bu, buDeriv] = _computeBernstein(u);
+    const auto [bv, bvDeriv] = _computeBernstein(v);
+
+    return _computePointAndDeriv(controlPoints, bu, bv, buDeriv, bvDeriv);
+}
 
-    /* y rotation */
-    x = x * std::cos(yRad) + z * std::sin(yRad);
-    z = -x * std::sin(yRad) + z * std::cos(yRad);
+std::tuple<float3, float3, float3> Mesh::computeTangentFrame(const float3 &pu, const float3 &pv) {
+    const float3 normal = normalize(cross(pu, pv));
 
-    /* z rotation */
-    x = x * std::cos(zRad) - y * std::sin(zRad);
-    y = x * std::sin(zRad) + y * std::cos(zRad);
+    /* Gram-Schmidt - pu is perpendicular to the normal up to rounding only */
+    const float3 tangent = normalize(pu - dot(pu, normal) * normal);
+    const float3 bitangent = cross(normal, tangent);
 
-    p.setX(x);
-    p.setY(y);
-    p.setZ(z);
+    return {tangent, bitangent, normal};
 }
 
 void Mesh::setControlPoints(const ControlPoints &controlPoints) {
     m_controlPoints = controlPoints;
-    m_triangles = _interpolateBezier(m_controlPoints);
+    m_triangles = _interpolateBezier(m_controlPoints, m_triangleAccuracy);
+    m_previewTriangles = _interpolateBezier(m_controlPoints, _getPreviewAccuracy());
+    ++m_revision;
 }
 
 std::tuple<BernsteinTable, BernsteinTable> Mesh::_computeBernstein(const float t) {
@@ -248,14 +406,16 @@ std::tuple<BernsteinTable, BernsteinTable> Mesh::_computeBernstein(const float t
     };
 }
 
-void Mesh::rotateFigure() {
-    static constexpr float kAlphaRot = 0.5f;
-    static constexpr float kBetaRot = 0.9f;
+void Mesh::rotateFigure(const float elapsedSeconds) {
+    /* angles per second */
+    static constexpr float kStepsPerSecond = 1000.0f / LIGHTING_CONSTANTS::ANIMATION_TIME_STEP_MS;
+    static constexpr float kAlphaRot = 0.5f * kStepsPerSecond;
+    static constexpr float kBetaRot = 0.9f * kStepsPerSecond;
     static constexpr float kDelta = 0.0f;
 
     for (auto &triangle: m_figure) {
         for (auto &vertex: triangle) {
-            vertex.rotate(kAlphaRot, kBetaRot, kDelta);
+            vertex.rotate(kAlphaRot * elapsedSeconds, kBetaRot * elapsedSeconds, kDelta);
         }
     }
 }
@@ -0,0 +1,151 @@
+//
+// Created by Jlisowskyy on 11/13/24.
+//
+
+/* internal includes */
+#include "../include/Rendering/NormalMap.h"
+#include "../include/Rendering/Mesh.h"
+#include "../include/ManagingObjects/ThreadPool.h"
+
+/* external includes */
+#include <cstring>
+
+NormalMap::NormalMap(const int32_t width, const int32_t height, const TexelLayout layout) : m_width(width),
+    m_height(height),
+    m_stride(TexelAddressing::stride(layout, width)),
+    m_xScale(static_cast<float>(width - 1)),
+    m_yScale(static_cast<float>(height - 1)),
+    m_layout(layout),
+    m_texels(TexelAddressing::size(layout, width, height)) {
+    m_data = m_texels.data();
+}
+
+NormalMap::NormalMap(const QImage &image, const TexelLayout layout) : NormalMap(image.width(), image.height(),
+                                                                                layout) {
+    Q_ASSERT(!image.isNull());
+
+    const QImage converted = image.convertToFormat(QImage::Format_ARGB32);
+
+    ThreadPool::getInstance().parallelFor(0, m_height, ROWS_PER_TASK, [&](const size_t row) {
+        const auto y = static_cast<int32_t>(row);
+        const auto *texels = reinterpret_cast<const QRgb *>(converted.constScanLine(y));
+
+        for (int32_t x = 0; x < m_width; ++x) {
+            const QRgb color = texels[x];
+
+            float3 normal(
+                (static_cast<float>(qRed(color)) - 127.0f) / 127.0f,
+                (static_cast<float>(qGreen(color)) - 127.0f) / 127.0f,
+                (static_cast<float>(qBlue(color)) - 127.0f) / 127.0f
+            );
+
+            /* flat fallback for black texels */
+            if (lengthSquared(normal) == 0.0f) {
+                normal = float3(0.0f, 0.0f, 1.0f);
+            }
+
+            _texelAt(x, y) = encode(normalize(normal));
+        }
+    });
+}
+
+NormalMap *NormalMap::bakeObjectSpace(const NormalMap &tangentMap, const ControlPoints &controlPoints) {
+    auto *baked = new NormalMap(tangentMap.m_width, tangentMap.m_height, tangentMap.m_layout);
+
+    /* inverse of the sampling mapping: x = v * xScale, y = (1 - u) * yScale */
+    const float xStep = tangentMap.m_xScale > 0.0f ? 1.0f / tangentMap.m_xScale : 0.0f;
+    const float yStep = tangentMap.m_yScale > 0.0f ? 1.0f / tangentMap.m_yScale : 0.0f;
+
+    /* surface evaluation per texel - rows are expensive enough on their own */
+    ThreadPool::getInstance().parallelFor(0, baked->m_height, 1, [&](const size_t row) {
+        const auto y = static_cast<int32_t>(row);
+        const float u = 1.0f - static_cast<float>(y) * yStep;
+
+        for (int32_t x = 0; x < baked->m_width; ++x) {
+            const float v = static_cast<float>(x) * xStep;
+
+            const auto [point, pu, pv] = Mesh::evaluateSurface(controlPoints, u, v);
+            /* same frame as the mesh vertices - orthonormal, so unit tangent space normals stay unit */
+            const auto [tangent, bitangent, normal] = Mesh::computeTangentFrame(pu, pv);
+            const float3 tangentNormal = decode(tangentMap._texelAt(x, y));
+
+            const float3 objectNormal = tangent * tangentNormal.x +
+                                        bitangent * tangentNormal.y +
+                                        normal * tangentNormal.z;
+
+            baked->_texelAt(x, y) = encode(lengthSquared(objectNormal) == 0.0f ? normal : normalize(objectNormal));
+        }
+    });
+
+    return baked;
+}
+
+NormalMap *NormalMap::fromHeightMap(const QImage &heightImage, const float strength, const TexelLayout layout) {
+    Q_ASSERT(!heightImage.isNull());
+
+    const QImage heights = heightImage.convertToFormat(QImage::Format_Grayscale8);
+    auto *result = new NormalMap(heights.width(), heights.height(), layout);
+
+    const int32_t width = result->m_width;
+    const int32_t height = result->m_height;
+    /* Sobel response is 8 times the central difference per texel - normalized, so strength scales the real gradient */
+    const float scale = strength / (8.0f * 255.0f);
+
+    /* scratch rows allocated once per chunk */
+    ThreadPool::getInstance().parallelForChunks(0, height, ROWS_PER_TASK, [&](const size_t chunkBegin,
+                                                                              const size_t chunkEnd) {
+        /* three source rows padded by one clamped texel on both sides */
+        std::vector<float> rows(3 * (width + 2));
+        std::vector<PackedNormal> packed(width);
+
+        for (auto y = static_cast<int32_t>(chunkBegin); y < static_cast<int32_t>(chunkEnd); ++y) {
+            for (int32_t r = 0; r < 3; ++r) {
+                const uchar *src = heights.constScanLine(std::clamp(y + r - 1, 0, height - 1));
+                float *dst = rows.data() + r * (width + 2);
+
+#pragma omp simd
+                for (int32_t x = 0; x < width; ++x) {
+                    dst[x + 1] = static_cast<float>(src[x]);
+                }
+
+                dst[0] = dst[1];
+                dst[width + 1] = dst[width];
+            }
+
+            const float *top = rows.data();
+            const float *mid = top + (width + 2);
+            const float *bottom = mid + (width + 2);
+
+#pragma omp simd
+            for (int32_t x = 0; x < width; ++x) {
+                /* gradient along image columns and image rows */
+                const float gx = (top[x + 2] + 2.0f * mid[x + 2] + bottom[x + 2]) -
+                                 (top[x] + 2.0f * mid[x] + bottom[x]);
+                const float gy = (bottom[x] + 2.0f * bottom[x + 1] + bottom[x + 2]) -
+                                 (top[x] + 2.0f * top[x + 1] + top[x + 2]);
+
+                /* (-dh/du, -dh/dv, 1) in the frame used by bakeObjectSpace: u runs up the rows, v along columns */
+                const float nx = gy * scale;
+                const float ny = -gx * scale;
+
+                /* encode() for upper hemisphere - z is always positive here, no folding needed */
+                const float invL1 = 1.0f / (std::abs(nx) + std::abs(ny) + 1.0f);
+                const float ex = nx * invL1 * SNORM_SCALE;
+                const float ey = ny * invL1 * SNORM_SCALE;
+
+                packed[x] = {
+                    static_cast<int16_t>(ex + (ex >= 0.0f ? 0.5f : -0.5f)),
+                    static_cast<int16_t>(ey + (ey >= 0.0f ? 0.5f : -0.5f))
+                };
+            }
+
+            for (int32_t x = 0; x < width;) {
+                const int32_t count = TexelAddressing::runLength(layout, width, x);
+                std::memcpy(&result->_texelAt(x, y), packed.data() + x, sizeof(PackedNormal) * count);
+                x += count;
+            }
+        }
+    });
+
+    return result;
+}
@@ -0,0 +1,22 @@
+//
+// Created by Jlisowskyy on 11/12/24.
+//
+
+/* internal includes */
+#include "../include/Rendering/RenderTarget.h"
+
+/* external includes */
+#include <algorithm>
+
+RenderTarget::RenderTarget() : m_bitMap(0, 0) {
+}
+
+void RenderTarget::resize(const int32_t width, const int32_t height) {
+    m_bitMap.resize(width, height);
+
+    const size_t required = static_cast<size_t>(width) * static_cast<size_t>(height);
+    if (required > m_zBuffer.capacity()) {
+        m_zBuffer.reserve(std::max(required, m_zBuffer.capacity() + m_zBuffer.capacity() / 2));
+    }
+    m_zBuffer.resize(required);
+}
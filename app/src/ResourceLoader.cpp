@@ -0,0 +1,199 @@
+//
+// Created by Jlisowskyy on 11/13/24.
+//
+
+/* internal includes */
+#include "../include/ManagingObjects/ResourceLoader.h"
+#include "../include/Rendering/TextureImage.h"
+#include "../include/Rendering/NormalMap.h"
+#include "../include/Rendering/VirtualTexture.h"
+
+/* external includes */
+#include <QBuffer>
+#include <QDebug>
+#include <QFile>
+#include <QImageIOHandler>
+#include <QImageReader>
+#include <QCoreApplication>
+#include <QtConcurrent>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+ResourceLoader::ResourceLoader(QObject *parent) : QObject(parent) {
+}
+
+ResourceLoader::~ResourceLoader() {
+    for (auto &generation: m_generations) {
+        generation.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /* finished signal will not be delivered anymore - dropping the watchers releases the pending results */
+    for (auto *watcher: m_watchers) {
+        watcher->waitForFinished();
+        delete watcher;
+    }
+}
+
+void ResourceLoader::loadTexture(const QString &path) {
+    /* header only - decides between resampled and streamed texture without decoding */
+    const QImageReader reader(path);
+    const QSize size = reader.size();
+
+    const bool isLarge = size.width() > RESOURCE_CONSTANTS::VIRTUAL_TEXTURE_THRESHOLD ||
+                         size.height() > RESOURCE_CONSTANTS::VIRTUAL_TEXTURE_THRESHOLD;
+
+    /* tiles decode clipped regions of the source - formats without clipping (PNG, TIFF, BMP) would decode the whole
+     * image for every single tile, those are resampled once instead */
+    const bool canStream = reader.supportsOption(QImageIOHandler::ClipRect);
+
+    if (isLarge && !canStream) {
+        qDebug() << "Texture format does not support partial decoding, resampling instead of streaming:" << path;
+    }
+
+    if (!isLarge || !canStream) {
+        _startJob<TextureImage>(_ResourceKind::TEXTURE, path, &ResourceLoader::textureLoaded,
+                                [this](const QString &jobPath, const auto &isCurrent) {
+                                    return _loadProcessed<TextureImage>(jobPath, isCurrent);
+                                });
+        return;
+    }
+
+    _startJob<VirtualTexture>(_ResourceKind::TEXTURE, path, &ResourceLoader::virtualTextureLoaded,
+                              [size](const QString &jobPath, [[maybe_unused]] const auto &isCurrent) {
+                                  auto texture = std::make_unique<VirtualTexture>(jobPath, size);
+
+                                  /* created on pool thread - hand over to the GUI thread which owns it */
+                                  texture->moveToThread(QCoreApplication::instance()->thread());
+                                  return texture->isValid() ? std::move(texture) : nullptr;
+                              });
+}
+
+void ResourceLoader::loadNormalMap(const QString &path) {
+    _startJob<NormalMap>(_ResourceKind::NORMAL_MAP, path, &ResourceLoader::normalMapLoaded,
+                         [this](const QString &jobPath, const auto &isCurrent) {
+                             return _loadProcessed<NormalMap>(jobPath, isCurrent);
+                         });
+}
+
+void ResourceLoader::loadHeightMap(const QString &path, const float strength) {
+    _startJob<NormalMap>(_ResourceKind::NORMAL_MAP, path, &ResourceLoader::normalMapLoaded,
+                         [strength](const QString &jobPath, const auto &isCurrent) -> std::unique_ptr<NormalMap> {
+                             QFile file(jobPath);
+                             if (!file.open(QIODevice::ReadOnly)) {
+                                 qWarning() << "Failed to load image from path:" << jobPath;
+                                 return nullptr;
+                             }
+
+                             const QImage image = decodeScaledImage(file.readAll());
+                             if (image.isNull() || !isCurrent()) {
+                                 return nullptr;
+                             }
+
+                             /* cheap enough to skip TextureCache - and the result depends on strength as well */
+                             const auto t0 = std::chrono::steady_clock::now();
+                             std::unique_ptr<NormalMap> normalMap(NormalMap::fromHeightMap(image, strength));
+                             const auto t1 = std::chrono::steady_clock::now();
+
+                             qDebug() << "Time spent on generating normal map: " << (t1 - t0).count() << " ns";
+                             return normalMap;
+                         });
+}
+
+QImage ResourceLoader::decodeScaledImage(const QByteArray &data) {
+    QBuffer buffer{};
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+
+    QImageReader reader(&buffer);
+
+    /* whole source is decoded before resampling - the reader limit would reject large images, so it is replaced by
+     * an explicit one */
+    if (const QSize size = reader.size(); size.isValid()) {
+        const qint64 requiredMegabytes = (static_cast<qint64>(size.width()) * size.height() * 4 >> 20) + 1;
+
+        if (requiredMegabytes > RESOURCE_CONSTANTS::MAX_DECODE_MEGABYTES) {
+            qWarning() << "Image of size" << size << "exceeds decode limit of"
+                    << RESOURCE_CONSTANTS::MAX_DECODE_MEGABYTES << "MB";
+            return {};
+        }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        reader.setAllocationLimit(static_cast<int>(std::max<qint64>(requiredMegabytes, reader.allocationLimit())));
+#endif
+    }
+
+    const QImage image = reader.read();
+
+    if (image.isNull()) {
+        qWarning() << "Failed to decode image:" << reader.errorString();
+        return {};
+    }
+
+    return image.scaled(RESOURCE_CONSTANTS::TEXTURE_IMAGE_SIZE, RESOURCE_CONSTANTS::TEXTURE_IMAGE_SIZE,
+                        Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+template<typename ResourceT, typename FactoryT>
+void ResourceLoader::_startJob(const _ResourceKind kind, const QString &path,
+                               void (ResourceLoader::*signal)(ResourceT *), FactoryT factory) {
+    const uint64_t generation = m_generations[static_cast<size_t>(kind)].fetch_add(1, std::memory_order_relaxed) + 1;
+
+    /* shared between the job and the delivery - undelivered resource is released together with the watcher */
+    auto result = std::make_shared<std::unique_ptr<ResourceT> >();
+
+    auto *watcher = new QFutureWatcher<void>();
+    m_watchers.push_back(watcher);
+
+    connect(watcher, &QFutureWatcher<void>::finished, this, [this, watcher, kind, generation, path, signal, result]() {
+        m_watchers.erase(std::find(m_watchers.begin(), m_watchers.end(), watcher));
+        watcher->deleteLater();
+
+        if (!_isCurrent(kind, generation)) {
+            return;
+        }
+
+        if (!*result) {
+            emit loadFailed(path);
+            return;
+        }
+
+        emit (this->*signal)(result->release());
+    });
+
+    watcher->setFuture(QtConcurrent::run([this, kind, generation, path, result, factory]() {
+        const auto isCurrent = [this, kind, generation]() {
+            return _isCurrent(kind, generation);
+        };
+
+        *result = factory(path, isCurrent);
+    }));
+}
+
+template<typename ResourceT, typename IsCurrentT>
+std::unique_ptr<ResourceT> ResourceLoader::_loadProcessed(const QString &path, const IsCurrentT &isCurrent) const {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to load image from path:" << path;
+        return nullptr;
+    }
+
+    /* hits never read the whole source */
+    const QString key = TextureCache::makeKey(file);
+
+    if (ResourceT *cached = m_cache.load<ResourceT>(key)) {
+        return std::unique_ptr<ResourceT>(cached);
+    }
+
+    const QImage image = decodeScaledImage(file.readAll());
+
+    /* superseded while decoding - skip the preprocessing */
+    if (image.isNull() || !isCurrent()) {
+        return nullptr;
+    }
+
+    auto resource = std::make_unique<ResourceT>(image);
+    m_cache.store(key, *resource);
+
+    return resource;
+}
@@ -6,9 +6,13 @@
 #include "../include/ManagingObjects/SceneMgr.h"
 #include "../include/Rendering/Mesh.h"
 #include "../include/Rendering/Texture.h"
+#include "../include/Rendering/TextureImage.h"
+#include "../include/Rendering/VirtualTexture.h"
 #include "../include/GraphicObjects/DrawingWidget.h"
 
 /* external includes */
+#include <algorithm>
+
 SceneMgr::SceneMgr(QObject *parent,
                    const QColor &color,
                    const bool drawNet,
@@ -16,29 +20,51 @@ SceneMgr::SceneMgr(QObject *parent,
                    const bool playAnimation,
                    const QColor &lightColor,
                    const int lightZ,
-                   QImage *image) : QObject(parent),
+                   const int lightCount,
+                   const float reflectorCoef) : QObject(parent),
                                     m_useTexture(useTexture),
                                     m_isAnimationPlaying(playAnimation),
                                     m_drawNet(drawNet),
-                                    m_fillType(getFillType()),
-                                    m_textureImg(image),
                                     m_color(color),
-                                    m_timer(new QTimer(this)),
-                                    m_lightZ(lightZ) {
+                                    m_frameTimer(new QTimer(this)),
+                                    m_lights(static_cast<size_t>(lightCount),
+                                             {lightColor, 0.0f, lightZ, reflectorCoef}),
+                                    m_idleTimer(new QTimer(this)) {
+    Q_ASSERT(lightCount > 0 && lightCount <= LIGHTING_CONSTANTS::MAX_LIGHT_COUNT);
+    _spreadLightPhases();
+
+    /* texture arrives later from the resource loader */
+    m_fillType = getFillType();
+
+    m_frameTimer->setSingleShot(true);
+    m_frameTimer->setTimerType(Qt::PreciseTimer);
+
+    m_idleTimer->setSingleShot(true);
+    m_idleTimer->setInterval(RENDER_CONSTANTS::REFINEMENT_IDLE_MS);
+    connect(m_idleTimer, &QTimer::timeout, this, &SceneMgr::_onIdle);
 }
 
 FillType SceneMgr::getFillType() const {
-    return m_useTexture && m_textureImg ? FillType::TEXTURE : FillType::SIMPLE_COLOR;
+    if (!m_useTexture) {
+        return FillType::SIMPLE_COLOR;
+    }
+
+    if (m_textureImg) {
+        return FillType::TEXTURE;
+    }
+
+    return m_virtualTexture ? FillType::VIRTUAL_TEXTURE : FillType::SIMPLE_COLOR;
 }
 
-void SceneMgr::redrawScene(DrawingWidget &drawingWidget, const Texture &texture, const Mesh &mesh) {
-    drawingWidget.clearContent();
+void SceneMgr::redrawScene(DrawingWidget &drawingWidget, [[maybe_unused]] const Texture &texture, const Mesh &mesh) {
+    drawingWidget.setNetVisible(m_drawNet);
 
+    /* hidden net is repositioned once it gets enabled again */
     if (m_drawNet) {
         _drawNet(drawingWidget, mesh);
     }
 
-    drawingWidget.updateScene();
+    invalidate();
 }
 
 void SceneMgr::bondWithComponents(DrawingWidget *drawingWidget, Texture *texture, Mesh *mesh) {
@@ -50,22 +76,42 @@ void SceneMgr::bondWithComponents(DrawingWidget *drawingWidget, Texture *texture
     m_isBound = true;
 
     connect(drawingWidget, &DrawingWidget::onElementsUpdate, this, &SceneMgr::_onElementsUpdate);
-    _addLightItem(drawingWidget);
+    _syncLightItems();
 
-    connect(m_timer, &QTimer::timeout, this, &SceneMgr::_onTimer);
-    m_timer->start(LIGHTING_CONSTANTS::ANIMATION_TIME_STEP_MS);
+    connect(m_frameTimer, &QTimer::timeout, this, &SceneMgr::_onFrame);
+
+    if (m_isAnimationPlaying) {
+        m_lastAnimationStep = std::chrono::steady_clock::now();
+        m_frameTimer->start(0);
+    }
+}
+
+void SceneMgr::invalidate() {
+    if (!m_isBound) {
+        return;
+    }
+
+    /* queued refinement slices would keep drawing with outdated geometry and resources */
+    _abandonRefinement();
+
+    /* all changes made during current event loop iteration end up in a single frame */
+    m_isFrameDirty = true;
+    m_frameTimer->start(0);
 }
 
 void SceneMgr::unbound() {
+    _abandonRefinement();
+    m_idleTimer->stop();
+
     m_texture = nullptr;
     m_mesh = nullptr;
     m_drawingWidget = nullptr;
     m_isBound = false;
 
     /* stop clock */
-    m_timer->stop();
-    delete m_timer;
-    m_timer = nullptr;
+    m_frameTimer->stop();
+    delete m_frameTimer;
+    m_frameTimer = nullptr;
 }
 
 void SceneMgr::setColor(const QColor &color) {
@@ -75,13 +121,23 @@ void SceneMgr::setColor(const QColor &color) {
 
     m_color = color;
 
-    if (m_isBound && !m_isAnimationPlaying) {
-        _drawTextureWithNormals(*m_drawingWidget, *m_texture, *m_mesh);
-    }
+    invalidate();
 }
 
 void SceneMgr::setIsAnimationPlayed(const bool isAnimationPlaying) {
+    if (m_isAnimationPlaying == isAnimationPlaying) {
+        return;
+    }
+
     m_isAnimationPlaying = isAnimationPlaying;
+
+    /* animation renders full frames on its own */
+    _abandonRefinement();
+
+    if (m_isBound && m_isAnimationPlaying) {
+        m_lastAnimationStep = std::chrono::steady_clock::now();
+        m_frameTimer->start(0);
+    }
 }
 
 void SceneMgr::setDrawNet(const bool drawNet) {
@@ -105,96 +161,337 @@ void SceneMgr::setUseTexture(const bool useTexture) {
     const FillType oldFill = m_fillType;
     m_fillType = getFillType();
 
-    if (m_isBound && !m_isAnimationPlaying && m_fillType != oldFill) {
-        _drawTextureWithNormals(*m_drawingWidget, *m_texture, *m_mesh);
+    if (m_fillType != oldFill) {
+        invalidate();
     }
 }
 
-void SceneMgr::setTextureImg(QImage *image) {
+void SceneMgr::setTextureImg(TextureImage *image) {
     if (image == m_textureImg) {
         return;
     }
 
+    /* only one color source is active at a time */
+    delete m_virtualTexture;
+    m_virtualTexture = nullptr;
+
     delete m_textureImg;
     m_textureImg = image;
+    m_fillType = getFillType();
 
-    const FillType oldFill = m_fillType;
+    /* new texture arrives asynchronously - always repaint */
+    invalidate();
+}
+
+void SceneMgr::setVirtualTexture(VirtualTexture *texture) {
+    if (texture == m_virtualTexture) {
+        return;
+    }
+
+    delete m_textureImg;
+    m_textureImg = nullptr;
+
+    delete m_virtualTexture;
+    m_virtualTexture = texture;
     m_fillType = getFillType();
 
-    if (m_isBound && !m_isAnimationPlaying && m_fillType != oldFill) {
-        _drawTextureWithNormals(*m_drawingWidget, *m_texture, *m_mesh);
+    if (m_virtualTexture) {
+        m_virtualTexture->setParent(this);
+        connect(m_virtualTexture, &VirtualTexture::tilesArrived, this, &SceneMgr::_onTilesArrived);
     }
+
+    invalidate();
+}
+
+void SceneMgr::setLights(const std::vector<LightDesc> &lights) {
+    Q_ASSERT(!lights.empty() && lights.size() <= LIGHTING_CONSTANTS::MAX_LIGHT_COUNT);
+
+    m_lights = lights;
+
+    if (m_isBound) {
+        _syncLightItems();
+    }
+
+    invalidate();
 }
 
 void SceneMgr::setLightZ(const int z) {
-    if (m_lightZ == z) {
+    for (LightDesc &light: m_lights) {
+        light.z = z;
+    }
+
+    invalidate();
+}
+
+void SceneMgr::setLightCount(const int count) {
+    Q_ASSERT(count > 0 && count <= LIGHTING_CONSTANTS::MAX_LIGHT_COUNT);
+
+    if (m_lights.size() == static_cast<size_t>(count)) {
         return;
     }
 
-    m_lightZ = z;
+    m_lights.resize(count, m_lights.back());
+    _spreadLightPhases();
 
-    if (m_isBound && !m_isAnimationPlaying) {
-        _drawTextureWithNormals(*m_drawingWidget, *m_texture, *m_mesh);
+    if (m_isBound) {
+        _syncLightItems();
     }
+
+    invalidate();
 }
 
 void SceneMgr::setLightColor(const QColor &color) {
+    for (LightDesc &light: m_lights) {
+        light.color = color;
+    }
+
     m_texture->setLightColor(color);
 
-    if (m_isBound && !m_isAnimationPlaying) {
-        _drawTextureWithNormals(*m_drawingWidget, *m_texture, *m_mesh);
+    invalidate();
+}
+
+void SceneMgr::setReflectorCoef(const float reflectorCoef) {
+    for (LightDesc &light: m_lights) {
+        light.coneExponent = reflectorCoef;
     }
+
+    invalidate();
 }
 
-void SceneMgr::_onTimer() {
+void SceneMgr::_onFrame() {
+    if (!m_isBound) {
+        return;
+    }
+
+    const auto frameStart = std::chrono::steady_clock::now();
+
+    if (m_isAnimationPlaying) {
+        _advanceAnimation(frameStart);
+    }
+
+    if (m_isFrameDirty) {
+        m_isFrameDirty = false;
+        _renderInteractive();
+    } else if (m_isAnimationPlaying) {
+        _abandonRefinement();
+
+        /* keep the animation responsive while user is still interacting */
+        _renderPass(m_idleTimer->isActive() ? _getPreviewPass() : FULL_PASS);
+    }
+
     if (!m_isAnimationPlaying) {
         return;
     }
 
-    m_lightPos = std::fmod(m_lightPos + LIGHTING_CONSTANTS::LIGHT_MOVEMENT_STEP, 1.0f);
+    /* frames longer than the time step are followed immediately - no backlog accumulates */
+    const auto frameTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - frameStart);
+    const int delay = LIGHTING_CONSTANTS::ANIMATION_TIME_STEP_MS - static_cast<int>(frameTime.count());
+    m_frameTimer->start(std::max(0, delay));
+}
+
+void SceneMgr::_advanceAnimation(const std::chrono::steady_clock::time_point now) {
+    const float elapsedSeconds = std::chrono::duration<float>(now - m_lastAnimationStep).count();
+    m_lastAnimationStep = now;
 
+    m_lightPos = std::fmod(m_lightPos + elapsedSeconds * LIGHTING_CONSTANTS::LIGHT_SPEED, 1.0f);
     _processLightPosition();
-    _drawTextureWithNormals(*m_drawingWidget, *m_texture, *m_mesh);
 
-    m_mesh->rotateFigure();
+    m_mesh->rotateFigure(elapsedSeconds);
+}
+
+void SceneMgr::_onElementsUpdate([[maybe_unused]] const DrawingWidget *sender) {
+    invalidate();
+}
+
+void SceneMgr::_onIdle() {
+    if (!m_isBound || m_isAnimationPlaying) {
+        return;
+    }
+
+    _abandonRefinement();
+
+    m_refinementStage = 0;
+    m_refinementPass = _createPass(REFINEMENT_PASSES[m_refinementStage]);
+    _scheduleRefinementSlice();
+}
+
+void SceneMgr::_onTilesArrived() {
+    /* animation and interaction repaint anyway - otherwise refine once the burst of arriving tiles settles */
+    if (!m_isBound || m_isAnimationPlaying || m_isFrameDirty) {
+        return;
+    }
+
+    m_idleTimer->start();
+}
+
+void SceneMgr::_renderInteractive() {
+    if (!m_isBound) {
+        return;
+    }
+
+    _abandonRefinement();
+    _renderPass(_getPreviewPass());
+
+    /* restart idle countdown - refinement begins once input stops */
+    m_idleTimer->start();
 }
 
-void SceneMgr::_onElementsUpdate(const DrawingWidget *sender) {
-    _addLightItem(sender);
-    _drawTextureWithNormals(*sender, *m_texture, *m_mesh);
+void SceneMgr::_renderPass(const _RenderPassDesc &desc) {
+    const auto pass = _createPass(desc);
+    _drawPassSlice(*pass, pass->triangles->size());
+    _presentPass(*pass);
 }
 
-void SceneMgr::_addLightItem(const DrawingWidget *drawingWidget) {
-    const auto point = _getLightPosition2D();
+const SceneMgr::_RenderPassDesc &SceneMgr::_getPreviewPass() const {
+    return m_usePerVertexPreview ? PER_VERTEX_PREVIEW_PASS : PREVIEW_PASS;
+}
+
+std::unique_ptr<SceneMgr::_RenderPass> SceneMgr::_createPass(const _RenderPassDesc &desc) {
+    Q_ASSERT(desc.resolutionDivider > 0);
+
+    auto pass = std::make_unique<_RenderPass>();
+    pass->desc = desc;
+    pass->shadingModel = desc.forcePerVertexLighting ? ShadingModel::PER_VERTEX : m_shadingModel;
+    /* normal map might still be loading, vertices are too sparse for it */
+    pass->useNormals = desc.allowNormals && m_useNormals && m_normalMap &&
+                       pass->shadingModel == ShadingModel::PER_PIXEL;
+
+    /* no sampling is running now - safe point for tile residency changes */
+    if (m_fillType == FillType::VIRTUAL_TEXTURE) {
+        m_virtualTexture->update();
+    }
+    pass->triangles = desc.usePreviewMesh ? &m_mesh->getPreviewMeshArr() : &m_mesh->getMeshArr();
+    pass->figure = &m_mesh->getFigure();
+    pass->meshRevision = m_mesh->getRevision();
+
+    const QPixmap *pixmap = m_drawingWidget->getPixMap();
+    const int width = std::max(1, pixmap->width() / desc.resolutionDivider);
+    const int height = std::max(1, pixmap->height() / desc.resolutionDivider);
+
+    /* uniform scaling keeps all the lighting directions intact */
+    const float scale = 1.0f / static_cast<float>(desc.resolutionDivider);
+
+    if (desc.resolutionDivider != 1) {
+        pass->scaledTriangles = *pass->triangles;
+        pass->scaledFigure = *pass->figure;
+
+        for (auto *arr: {&pass->scaledTriangles, &pass->scaledFigure}) {
+            for (auto &triangle: *arr) {
+                for (auto &vertex: triangle) {
+                    vertex.rotatedPosition *= scale;
+                }
+            }
+        }
+
+        pass->triangles = &pass->scaledTriangles;
+        pass->figure = &pass->scaledFigure;
+    }
+
+    /* shadow maps hold the full mesh - the coarse one would shadow itself */
+    Q_ASSERT(!desc.allowShadows || !desc.usePreviewMesh);
+    m_texture->prepareShading(pass->shading, *m_mesh, *pass->triangles, _getLightSources(), scale, width, height,
+                              pass->useNormals, desc.allowShadows, pass->shadingModel);
 
-    m_lightEllipse = drawingWidget->scene()->addEllipse(
-        point.x() - UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS,
-        point.y() - UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS,
-        2 * UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS,
-        2 * UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS,
-        QPen(UI_CONSTANTS::LIGHT_SOURCE_COLOR),
-        QBrush(UI_CONSTANTS::LIGHT_SOURCE_COLOR)
-    );
+    m_renderTarget.resize(width, height);
+    pass->target = &m_renderTarget;
+    Texture::prepareFrame(m_renderTarget.getBitMap(), m_renderTarget.getZBuffer());
 
-    m_lightEllipse1 = drawingWidget->scene()->addEllipse(
-        -(point.x() - UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS),
-        -(point.y() - UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS),
-        2 * UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS,
-        2 * UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS,
-        QPen(UI_CONSTANTS::LIGHT_SOURCE_COLOR),
-        QBrush(UI_CONSTANTS::LIGHT_SOURCE_COLOR)
-    );
+    return pass;
+}
+
+void SceneMgr::_drawPassSlice(_RenderPass &pass, const size_t maxTriangles) const {
+    const auto t0 = std::chrono::steady_clock::now();
+
+    const size_t begin = pass.nextTriangle;
+    const size_t end = std::min(pass.triangles->size(), begin + maxTriangles);
+
+    if (pass.useNormals) {
+        _drawTriangles<true>(pass, begin, end);
+    } else {
+        _drawTriangles<false>(pass, begin, end);
+    }
+
+    pass.nextTriangle = end;
+    pass.renderTime += std::chrono::steady_clock::now() - t0;
+}
+
+void SceneMgr::_presentPass(_RenderPass &pass) {
+    QPixmap *pixmap = m_drawingWidget->getPixMap();
+
+    m_texture->finishFrame(*pixmap, pass.target->getBitMap(), pass.target->getZBuffer(), *pass.triangles,
+                           *pass.figure, *m_mesh, pass.renderTime);
+    m_drawingWidget->setPixmap(pixmap);
+
+    emit framePresented();
+}
+
+void SceneMgr::_scheduleRefinementSlice() {
+    QTimer::singleShot(0, this, [this, generation = m_renderGeneration] {
+        /* input arrived meanwhile - drop the outdated work */
+        if (generation != m_renderGeneration || !m_refinementPass) {
+            return;
+        }
+
+        /* geometry changes invalidate the scene on their own - this only catches a path that does not */
+        if (m_refinementPass->meshRevision != m_mesh->getRevision()) {
+            invalidate();
+            return;
+        }
+
+        _drawPassSlice(*m_refinementPass, RENDER_CONSTANTS::REFINEMENT_TRIANGLES_PER_SLICE);
+
+        if (m_refinementPass->nextTriangle < m_refinementPass->triangles->size()) {
+            _scheduleRefinementSlice();
+            return;
+        }
+
+        _presentPass(*m_refinementPass);
+
+        if (++m_refinementStage < std::size(REFINEMENT_PASSES)) {
+            m_refinementPass = _createPass(REFINEMENT_PASSES[m_refinementStage]);
+            _scheduleRefinementSlice();
+        } else {
+            m_refinementPass.reset();
+        }
+    });
+}
+
+void SceneMgr::_abandonRefinement() {
+    ++m_renderGeneration;
+    m_refinementPass.reset();
+}
+
+void SceneMgr::_syncLightItems() {
+    const size_t count = m_lights.size();
+
+    while (m_lightEllipses.size() > count) {
+        delete m_lightEllipses.back();
+        m_lightEllipses.pop_back();
+    }
+
+    while (m_lightEllipses.size() < count) {
+        m_lightEllipses.push_back(m_drawingWidget->scene()->addEllipse(
+            0, 0, 0, 0,
+            QPen(UI_CONSTANTS::LIGHT_SOURCE_COLOR),
+            QBrush(UI_CONSTANTS::LIGHT_SOURCE_COLOR)
+        ));
+    }
+
+    _processLightPosition();
 }
 
 void SceneMgr::_drawNet(DrawingWidget &drawingWidget, const Mesh &mesh) {
     /* Draw control points */
+    size_t pointIdx = 0;
     for (auto point: mesh.getControlPoints()) {
-        drawingWidget.drawBezierPoint(mesh.getPointAlignedWithMeshPlain(point));
+        drawingWidget.setBezierPoint(pointIdx++, mesh.getPointAlignedWithMeshPlain(point));
     }
 
     /* Draw lines for control points */
     static constexpr int CONTROL_POINTS_MATRIX_SIZE_INT = BEZIER_CONSTANTS::CONTROL_POINTS_MATRIX_SIZE;
     static constexpr int CONTROL_POINTS_COUNT_INT = BEZIER_CONSTANTS::CONTROL_POINTS_COUNT;
+    size_t lineIdx = 0;
     for (int i = 0; i < CONTROL_POINTS_COUNT_INT - 1; i++) {
         const int row = i / CONTROL_POINTS_MATRIX_SIZE_INT;
         const int col = i % CONTROL_POINTS_MATRIX_SIZE_INT;
@@ -214,64 +511,61 @@ void SceneMgr::_drawNet(DrawingWidget &drawingWidget, const Mesh &mesh) {
             auto point1 = mesh.getControlPoints()[i];
             auto point2 = mesh.getControlPoints()[idx];
 
-            drawingWidget.drawBezierLine(mesh.getPointAlignedWithMeshPlain(point1),
-                                         mesh.getPointAlignedWithMeshPlain(point2));
+            drawingWidget.setBezierLine(lineIdx++, mesh.getPointAlignedWithMeshPlain(point1),
+                                        mesh.getPointAlignedWithMeshPlain(point2));
         }
     }
 }
 
 template<bool drawNormals>
-void SceneMgr::_drawTexture(const DrawingWidget &drawingWidget, const Texture &texture, const Mesh &mesh) {
+void SceneMgr::_drawTriangles(_RenderPass &pass, const size_t begin, const size_t end) const {
     switch (m_fillType) {
         case FillType::TEXTURE: {
-            texture.fillPixmap<drawNormals>(*drawingWidget.getPixMap(), mesh,
-                                            [this](const float u, const float v) {
-                                                return m_textureImg->pixelColor(
-                                                    static_cast<int>(v * static_cast<float>(m_textureImg->width() - 1)),
-                                                    static_cast<int>(
-                                                        (1.0f - u) * static_cast<float>(m_textureImg->height() - 1))
-                                                );
-                                            },
-                                            _getLightPos()
+            m_texture->drawTriangles<drawNormals>(pass.target->getBitMap(), pass.target->getZBuffer(),
+                                                  *pass.triangles, begin, end,
+                                                  TextureColorGetter{m_textureImg},
+                                                  pass.shading
+            );
+        }
+        break;
+        case FillType::VIRTUAL_TEXTURE: {
+            m_texture->drawTriangles<drawNormals>(pass.target->getBitMap(), pass.target->getZBuffer(),
+                                                  *pass.triangles, begin, end,
+                                                  VirtualTextureColorGetter{m_virtualTexture},
+                                                  pass.shading
             );
         }
         break;
         case FillType::SIMPLE_COLOR: {
-            texture.fillPixmap<drawNormals>(*drawingWidget.getPixMap(), mesh,
-                                            [this]([[maybe_unused]] const float u, [[maybe_unused]] const float v) {
-                                                return m_color;
-                                            },
-                                            _getLightPos()
+            m_texture->drawTriangles<drawNormals>(pass.target->getBitMap(), pass.target->getZBuffer(),
+                                                  *pass.triangles, begin, end,
+                                                  PlainColorGetter{m_color.rgb()},
+                                                  pass.shading
             );
         }
         break;
         default:
             Q_ASSERT(false);
     }
-    drawingWidget.setPixmap(drawingWidget.getPixMap());
 }
 
 void SceneMgr::_processLightPosition() {
-    const auto point = _getLightPosition2D();
-
-    m_lightEllipse->setRect(
-        point.x() - UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS,
-        point.y() - UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS,
-        2 * UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS,
-        2 * UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS
-    );
-
-    m_lightEllipse1->setRect(
-        -(point.x() - UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS),
-        -(point.y() - UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS),
-        2 * UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS,
-        2 * UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS
-    );
+    for (size_t idx = 0; idx < m_lightEllipses.size(); ++idx) {
+        const auto point = _getLightPosition2D(idx);
+
+        m_lightEllipses[idx]->setRect(
+            point.x() - UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS,
+            point.y() - UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS,
+            2 * UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS,
+            2 * UI_CONSTANTS::DEFAULT_LIGHT_SOURCE_RADIUS
+        );
+    }
 }
 
-QPointF SceneMgr::_getLightPosition2D() const {
+QPointF SceneMgr::_getLightPosition2D(const size_t idx) const {
     const float spiralRadius = UI_CONSTANTS::DEFAULT_LIGHT_MOVE_RADIUS * m_lightPos;
-    const float radian = 2.0f * static_cast<float>(M_PI) * LIGHTING_CONSTANTS::NUMBER_OF_SPIRALS * m_lightPos;
+    const float radian = 2.0f * static_cast<float>(M_PI) * LIGHTING_CONSTANTS::NUMBER_OF_SPIRALS * m_lightPos +
+                         m_lights[idx].phase;
 
     const float x = spiralRadius * std::cos(radian);
     const float y = spiralRadius * std::sin(radian);
@@ -279,22 +573,43 @@ QPointF SceneMgr::_getLightPosition2D() const {
     return {x, y};
 }
 
-QVector3D SceneMgr::_getLightPos() const {
-    const QPointF point2D = _getLightPosition2D();
-    return {static_cast<float>(point2D.x()), static_cast<float>(point2D.y()), static_cast<float>(m_lightZ)};
+std::vector<LightSource> SceneMgr::_getLightSources() const {
+    std::vector<LightSource> sources{};
+    sources.reserve(m_lights.size());
+
+    for (size_t idx = 0; idx < m_lights.size(); ++idx) {
+        const LightDesc &light = m_lights[idx];
+        const QPointF point2D = _getLightPosition2D(idx);
+
+        sources.push_back({
+            {static_cast<float>(point2D.x()), static_cast<float>(point2D.y()), static_cast<float>(light.z)},
+            float3(light.color.redF(), light.color.greenF(), light.color.blueF()),
+            light.coneExponent
+        });
+    }
+
+    return sources;
+}
+
+void SceneMgr::_spreadLightPhases() {
+    for (size_t idx = 0; idx < m_lights.size(); ++idx) {
+        m_lights[idx].phase = 2.0f * static_cast<float>(M_PI) * static_cast<float>(idx) /
+                              static_cast<float>(m_lights.size());
+    }
 }
 
-void SceneMgr::setNormalMap(QImage *image) {
+void SceneMgr::setNormalMap(NormalMap *image) {
     if (image == m_normalMap) {
         return;
     }
 
+    /* refinement pass may still sample the map baked from the old one */
+    _abandonRefinement();
+
     m_normalMap = image;
     m_texture->setNormalMap(image);
 
-    if (m_isBound && !m_isAnimationPlaying) {
-        _drawTextureWithNormals(*m_drawingWidget, *m_texture, *m_mesh);
-    }
+    invalidate();
 }
 
 void SceneMgr::setUseNormals(const bool useNormals) {
@@ -304,15 +619,19 @@ void SceneMgr::setUseNormals(const bool useNormals) {
 
     m_useNormals = useNormals;
 
-    if (m_isBound && !m_isAnimationPlaying) {
-        _drawTextureWithNormals(*m_drawingWidget, *m_texture, *m_mesh);
-    }
+    invalidate();
 }
 
-void SceneMgr::_drawTextureWithNormals(const DrawingWidget &drawingWidget, const Texture &texture, const Mesh &mesh) {
-    if (m_useNormals) {
-        _drawTexture<true>(drawingWidget, texture, mesh);
-    } else {
-        _drawTexture<false>(drawingWidget, texture, mesh);
+void SceneMgr::setShadingModel(const ShadingModel model) {
+    if (m_shadingModel == model) {
+        return;
     }
+
+    m_shadingModel = model;
+
+    invalidate();
+}
+
+void SceneMgr::setUsePerVertexPreview(const bool usePerVertexPreview) {
+    m_usePerVertexPreview = usePerVertexPreview;
 }
@@ -0,0 +1,144 @@
+//
+// Created by Jlisowskyy on 11/16/24.
+//
+
+/* internal includes */
+#include "../include/Rendering/ShadowMap.h"
+
+/* external includes */
+#include <algorithm>
+#include <cmath>
+
+void ShadowMap::build(const float3 &lightPosition, const MeshArr &triangles, const uint64_t meshRevision) {
+    m_isBuilt = true;
+    m_meshRevision = meshRevision;
+    m_lightPosition = lightPosition;
+
+    m_forward = -normalize(lightPosition);
+    const float3 helper = std::abs(m_forward.y) < 0.9f ? float3(0.0f, 1.0f, 0.0f) : float3(1.0f, 0.0f, 0.0f);
+    m_right = normalize(cross(helper, m_forward));
+    m_up = cross(m_forward, m_right);
+
+    /* frustum fitted to the bounding sphere of the mesh around the origin */
+    float radiusSq = 0.0f;
+    for (const auto &triangle: triangles) {
+        for (const auto &vertex: triangle) {
+            radiusSq = std::max(radiusSq, lengthSquared(vertex.rotatedPosition));
+        }
+    }
+
+    const float distanceSq = lengthSquared(lightPosition);
+    const float tanHalfFov = distanceSq > radiusSq
+                                 ? std::min(MAX_TAN_HALF_FOV, std::sqrt(radiusSq / (distanceSq - radiusSq)))
+                                 : MAX_TAN_HALF_FOV;
+    m_focal = 0.5f * static_cast<float>(SIZE) / std::max(tanHalfFov, 1e-3f);
+
+    m_invDepth.assign(static_cast<size_t>(SIZE) * SIZE, 0.0f);
+
+    for (const auto &triangle: triangles) {
+        _rasterizeDepth(
+            _project(triangle[0].rotatedPosition),
+            _project(triangle[1].rotatedPosition),
+            _project(triangle[2].rotatedPosition)
+        );
+    }
+}
+
+bool ShadowMap::isValidFor(const float3 &lightPosition, const uint64_t meshRevision) const {
+    return m_isBuilt && m_meshRevision == meshRevision &&
+           lengthSquared(lightPosition - m_lightPosition) <=
+           LIGHTING_CONSTANTS::SHADOW_MAP_LIGHT_THRESHOLD * LIGHTING_CONSTANTS::SHADOW_MAP_LIGHT_THRESHOLD;
+}
+
+float ShadowMap::visibility(const float3 &worldPos) const {
+    const float3 projected = _project(worldPos);
+    const float depth = projected.z;
+
+    /* the map covers only what lies in front of the light */
+    if (depth <= NEAR_PLANE) {
+        return 1.0f;
+    }
+
+    /* surface is allowed to sit a few texels behind its own stored depth */
+    const float biasedDepth = depth - LIGHTING_CONSTANTS::SHADOW_BIAS_TEXELS * depth / m_focal;
+
+    const auto centerX = static_cast<int32_t>(std::floor(projected.x));
+    const auto centerY = static_cast<int32_t>(std::floor(projected.y));
+
+    static constexpr int32_t RADIUS = LIGHTING_CONSTANTS::SHADOW_PCF_RADIUS;
+    static constexpr float TAP_COUNT = static_cast<float>((2 * RADIUS + 1) * (2 * RADIUS + 1));
+
+    float litTaps = 0.0f;
+    for (int32_t dy = -RADIUS; dy <= RADIUS; ++dy) {
+        for (int32_t dx = -RADIUS; dx <= RADIUS; ++dx) {
+            const int32_t x = centerX + dx;
+            const int32_t y = centerY + dy;
+
+            if (x < 0 || y < 0 || x >= SIZE || y >= SIZE) {
+                litTaps += 1.0f;
+                continue;
+            }
+
+            /* depth <= 1 / invDepth without the division, empty texels hold 0 */
+            const float invDepth = m_invDepth[static_cast<size_t>(y) * SIZE + x];
+            litTaps += biasedDepth * invDepth <= 1.0f ? 1.0f : 0.0f;
+        }
+    }
+
+    return litTaps / TAP_COUNT;
+}
+
+float3 ShadowMap::_project(const float3 &worldPos) const {
+    const float3 d = worldPos - m_lightPosition;
+    const float depth = dot(d, m_forward);
+    const float scale = m_focal / std::max(depth, NEAR_PLANE);
+
+    return {
+        fmadd(dot(d, m_right), scale, 0.5f * static_cast<float>(SIZE)),
+        fmadd(dot(d, m_up), scale, 0.5f * static_cast<float>(SIZE)),
+        depth
+    };
+}
+
+void ShadowMap::_rasterizeDepth(const float3 &p0, const float3 &p1, const float3 &p2) {
+    /* clipping is not worth it - such triangles cannot shadow anything lit by this light anyway */
+    if (p0.z <= NEAR_PLANE || p1.z <= NEAR_PLANE || p2.z <= NEAR_PLANE) {
+        return;
+    }
+
+    const float area = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+    if (std::abs(area) < 1e-6f) {
+        return;
+    }
+
+    const int32_t x0 = std::max(0, static_cast<int32_t>(std::floor(std::min({p0.x, p1.x, p2.x}))));
+    const int32_t x1 = std::min(SIZE - 1, static_cast<int32_t>(std::ceil(std::max({p0.x, p1.x, p2.x}))));
+    const int32_t y0 = std::max(0, static_cast<int32_t>(std::floor(std::min({p0.y, p1.y, p2.y}))));
+    const int32_t y1 = std::min(SIZE - 1, static_cast<int32_t>(std::ceil(std::max({p0.y, p1.y, p2.y}))));
+
+    /* reciprocal depth interpolates linearly in map space - perspective correct */
+    const float invArea = 1.0f / area;
+    const float inv0 = 1.0f / p0.z;
+    const float inv1 = 1.0f / p1.z;
+    const float inv2 = 1.0f / p2.z;
+
+    for (int32_t y = y0; y <= y1; ++y) {
+        const float py = static_cast<float>(y) + 0.5f;
+        float *row = m_invDepth.data() + static_cast<size_t>(y) * SIZE;
+
+        for (int32_t x = x0; x <= x1; ++x) {
+            const float px = static_cast<float>(x) + 0.5f;
+
+            /* edge functions normalized by the signed area - both windings are accepted */
+            const float w0 = ((p1.x - px) * (p2.y - py) - (p2.x - px) * (p1.y - py)) * invArea;
+            const float w1 = ((p2.x - px) * (p0.y - py) - (p0.x - px) * (p2.y - py)) * invArea;
+            const float w2 = 1.0f - w0 - w1;
+
+            if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+                continue;
+            }
+
+            row[x] = std::max(row[x], w0 * inv0 + w1 * inv1 + w2 * inv2);
+        }
+    }
+}
@@ -10,12 +10,15 @@
 #include "../include/Rendering/Mesh.h"
 #include "../include/Rendering/Texture.h"
 #include "../include/ManagingObjects/SceneMgr.h"
+#include "../include/ManagingObjects/ResourceLoader.h"
+#include "../include/ManagingObjects/ThreadPool.h"
 
 /* external includes */
 #include <vector>
 #include <QColorDialog>
 #include <QDebug>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QFile>
 #include <QTextStream>
 #include <QVector3D>
@@ -27,8 +30,24 @@
 
 StateMgr::StateMgr(QObject *parent, QWidget *widgetParent, DrawingWidget *drawingWidget) : QObject(parent),
     m_parentWidget(widgetParent),
-    m_drawingWidget(drawingWidget) {
+    m_drawingWidget(drawingWidget),
+    m_resourceLoader(new ResourceLoader(this)),
+    m_threadCountTimer(new QTimer(this)) {
     Q_ASSERT(parent && widgetParent && drawingWidget);
+    m_startupTimer.start();
+
+    m_threadCountTimer->setSingleShot(true);
+    m_threadCountTimer->setInterval(THREAD_CONSTANTS::RESIZE_DEBOUNCE_MS);
+    connect(m_threadCountTimer, &QTimer::timeout, this, &StateMgr::_onThreadCountSettled);
+
+    connect(m_resourceLoader, &ResourceLoader::loadFailed, this, [this]([[maybe_unused]] const QString &path) {
+        _showToast("Failed to load image");
+    });
+
+    /* decoding runs while the rest of the window is being constructed, results are delivered once the event loop
+     * starts - after loadDefaultSettings() connected the scene */
+    m_resourceLoader->loadTexture(RESOURCE_CONSTANTS::DEFAULT_TEXTURE_PATH);
+    m_resourceLoader->loadNormalMap(RESOURCE_CONSTANTS::DEFAULT_NORMAL_MAP_PATH);
 }
 
 StateMgr::~StateMgr() = default;
@@ -40,10 +59,13 @@ void StateMgr::connectToToolBar(ToolBar *toolBar) {
         {toolBar->m_alphaSlider, &StateMgr::onAlphaChanged},
         {toolBar->m_betaSlider, &StateMgr::onBetaChanged},
         {toolBar->m_deltaSlider, &StateMgr::onDeltaChanged},
+        {toolBar->m_kaSlider, &StateMgr::onKAChanged},
         {toolBar->m_ksSlider, &StateMgr::onKSChanged},
         {toolBar->m_kdSlider, &StateMgr::onKDChanged},
         {toolBar->m_mSlider, &StateMgr::onMChanged},
         {toolBar->m_lightningPositionSlider, &StateMgr::onLightZChanged},
+        {toolBar->m_lightCountSlider, &StateMgr::onLightCountChanged},
+        {toolBar->m_threadCountSlider, &StateMgr::onThreadCountChanged},
         {toolBar->m_reflectorMSlider, &StateMgr::onReflectorCoefChanged}
     };
 
@@ -56,6 +78,7 @@ void StateMgr::connectToToolBar(ToolBar *toolBar) {
         {toolBar->m_loadTextureButton, &StateMgr::onLoadTexturesTriggered},
         {toolBar->m_loadBezierPointsButton, &StateMgr::onLoadBezierPointsTriggered},
         {toolBar->m_loadNormalVectorsButton, &StateMgr::onLoadNormalVectorsTriggered},
+        {toolBar->m_loadHeightMapButton, &StateMgr::onLoadHeightMapTriggered},
         {toolBar->m_changePlainColorButton, &StateMgr::onColorChangedTriggered},
         {toolBar->m_changeLightColorButton, &StateMgr::onLightColorChangedTriggered},
     };
@@ -69,8 +92,11 @@ void StateMgr::connectToToolBar(ToolBar *toolBar) {
         {toolBar->m_drawNetButton, &StateMgr::onDrawNetChanged},
         {toolBar->m_enableTextureButton, &StateMgr::onEnableTextureChanged},
         {toolBar->m_enableNormalVectorsButton, &StateMgr::onEnableNormalVectorsChanged},
+        {toolBar->m_perVertexLightingButton, &StateMgr::onPerVertexLightingChanged},
+        {toolBar->m_perVertexPreviewButton, &StateMgr::onPerVertexPreviewChanged},
         {toolBar->m_stopLightMovementButton, &StateMgr::onStopLightingMovementChanged},
-        {toolBar->m_changeReflectionButton, &StateMgr::onUseReflectorChanged}
+        {toolBar->m_changeReflectionButton, &StateMgr::onUseReflectorChanged},
+        {toolBar->m_enableShadowsButton, &StateMgr::onUseShadowsChanged}
     };
 
     for (const auto &[action, proc]: vActionBoolProc) {
@@ -92,11 +118,10 @@ void StateMgr::loadDefaultSettings() {
                               UI_CONSTANTS::DEFAULT_PLAY_ANIMATION,
                               LIGHTING_CONSTANTS::DEFAULT_LIGHT_COLOR,
                               VIEW_SETTINGS::DEFAULT_LIGHT_Z,
-                              _loadTextureFromFile(RESOURCE_CONSTANTS::DEFAULT_TEXTURE_PATH)
+                              LIGHTING_CONSTANTS::DEFAULT_LIGHT_COUNT,
+                              LIGHTING_CONSTANTS::DEFAULT_REFLECTION_COEF
     );
 
-    _loadTexture(RESOURCE_CONSTANTS::DEFAULT_TEXTURE_PATH);
-
     m_mesh = new Mesh(this,
                       _loadBezierPointsOpenFile(RESOURCE_CONSTANTS::DEFAULT_CONTROL_POINTS_PATH, nullptr),
                       VIEW_SETTINGS::DEFAULT_ALPHA,
@@ -106,21 +131,31 @@ void StateMgr::loadDefaultSettings() {
     );
 
     m_texture = new Texture(this,
+                            LIGHTING_CONSTANTS::DEFAULT_KA,
                             LIGHTING_CONSTANTS::DEFAULT_KS,
                             LIGHTING_CONSTANTS::DEFAULT_KD,
                             LIGHTING_CONSTANTS::DEFAULT_M,
                             LIGHTING_CONSTANTS::DEFAULT_LIGHT_COLOR,
-                            LIGHTING_CONSTANTS::USE_REFLECTORS,
-                            LIGHTING_CONSTANTS::DEFAULT_REFLECTION_COEF
+                            LIGHTING_CONSTANTS::USE_REFLECTORS
     );
 
     m_drawingWidget->setObserverDistance(VIEW_SETTINGS::DEFAULT_OBSERVER_DISTANCE);
     m_sceneMgr->bondWithComponents(m_drawingWidget, m_texture, m_mesh);
 
-    _loadNormalMap(RESOURCE_CONSTANTS::DEFAULT_NORMAL_MAP_PATH);
+    connect(m_resourceLoader, &ResourceLoader::textureLoaded, m_sceneMgr, &SceneMgr::setTextureImg);
+    connect(m_resourceLoader, &ResourceLoader::normalMapLoaded, m_sceneMgr, &SceneMgr::setNormalMap);
+    connect(m_resourceLoader, &ResourceLoader::virtualTextureLoaded, m_sceneMgr, &SceneMgr::setVirtualTexture);
+    m_firstFrameConnection = connect(m_sceneMgr, &SceneMgr::framePresented, this, &StateMgr::_onFramePresented);
+
+    /* geometry is ready - first frame does not wait for textures, they repaint the scene on arrival */
     redraw();
 }
 
+void StateMgr::_onFramePresented() {
+    disconnect(m_firstFrameConnection);
+    qDebug() << "Time to first frame: " << m_startupTimer.elapsed() << " ms";
+}
+
 void StateMgr::redraw() {
     m_sceneMgr->redrawScene(*m_drawingWidget, *m_texture, *m_mesh);
 }
@@ -145,27 +180,41 @@ void StateMgr::onDeltaChanged(const double value) {
     redraw();
 }
 
+void StateMgr::onKAChanged(const double value) {
+    m_texture->setKaCoef(static_cast<float>(value));
+    m_sceneMgr->invalidate();
+}
+
 void StateMgr::onKSChanged(const double value) {
     m_texture->setKsCoef(static_cast<float>(value));
-    redraw();
+    m_sceneMgr->invalidate();
 }
 
 void StateMgr::onKDChanged(const double value) {
     m_texture->setKdCoef(static_cast<float>(value));
-    redraw();
+    m_sceneMgr->invalidate();
 }
 
 void StateMgr::onMChanged(const double value) {
     m_texture->setMCoef(static_cast<float>(value));
-    redraw();
+    m_sceneMgr->invalidate();
 }
 
 void StateMgr::onLightZChanged(double value) {
     m_sceneMgr->setLightZ(static_cast<float>(value));
 }
 
+void StateMgr::onLightCountChanged(const double value) {
+    m_sceneMgr->setLightCount(static_cast<int>(std::lround(value)));
+}
+
+void StateMgr::onThreadCountChanged(const double value) {
+    m_pendingThreadCount = static_cast<size_t>(std::lround(value));
+    m_threadCountTimer->start();
+}
+
 void StateMgr::onReflectorCoefChanged(const double value) {
-    m_texture->setReflectorCoef(static_cast<float>(value));
+    m_sceneMgr->setReflectorCoef(static_cast<float>(value));
 }
 
 void StateMgr::onDrawNetChanged(const bool isChecked) {
@@ -180,13 +229,26 @@ void StateMgr::onEnableNormalVectorsChanged(const bool isChecked) {
     m_sceneMgr->setUseNormals(isChecked);
 }
 
+void StateMgr::onPerVertexLightingChanged(const bool isChecked) {
+    m_sceneMgr->setShadingModel(isChecked ? ShadingModel::PER_VERTEX : ShadingModel::PER_PIXEL);
+}
+
+void StateMgr::onPerVertexPreviewChanged(const bool isChecked) {
+    m_sceneMgr->setUsePerVertexPreview(isChecked);
+}
+
 void StateMgr::onStopLightingMovementChanged(const bool isChecked) {
     m_sceneMgr->setIsAnimationPlayed(!isChecked);
 }
 
 void StateMgr::onUseReflectorChanged(const bool isChecked) {
     m_texture->setUseReflector(isChecked);
-    redraw();
+    m_sceneMgr->invalidate();
+}
+
+void StateMgr::onUseShadowsChanged(const bool isChecked) {
+    m_texture->setUseShadows(isChecked);
+    m_sceneMgr->invalidate();
 }
 
 void StateMgr::onLoadBezierPointsTriggered() {
@@ -208,6 +270,21 @@ void StateMgr::onLoadNormalVectorsTriggered() {
     }, "");
 }
 
+void StateMgr::onLoadHeightMapTriggered() {
+    _openFileDialog([this](const QString &path) {
+        bool ok{};
+        const double strength = QInputDialog::getDouble(m_parentWidget, "Height map", "Normal strength:",
+                                                        RESOURCE_CONSTANTS::HEIGHT_MAP_DEFAULT_STRENGTH,
+                                                        RESOURCE_CONSTANTS::HEIGHT_MAP_MIN_STRENGTH,
+                                                        RESOURCE_CONSTANTS::HEIGHT_MAP_MAX_STRENGTH,
+                                                        2, &ok);
+
+        if (ok) {
+            _loadHeightMap(path, static_cast<float>(strength));
+        }
+    }, "Images (*.png *.jpg *.bmp);;All Files (*)");
+}
+
 void StateMgr::onColorChangedTriggered() {
     const QColor selectedColor = QColorDialog::getColor(Qt::white, m_parentWidget, "Choose Color");
     if (!selectedColor.isValid()) {
@@ -342,6 +419,13 @@ ControlPoints StateMgr::_loadBezierPointsParse(QFile &file, bool *ok) {
     return controlPoints;
 }
 
+void StateMgr::_onThreadCountSettled() {
+    /* loader jobs may be inside of a loop on their threads - retry later instead of blocking the GUI on them */
+    if (!ThreadPool::getInstance().tryResize(m_pendingThreadCount)) {
+        m_threadCountTimer->start();
+    }
+}
+
 void StateMgr::_showToast(const QString &message, int duration) {
     /* temporary */
     return;
@@ -365,27 +449,8 @@ void StateMgr::_showToast(const QString &message, int duration) {
 }
 
 void StateMgr::_loadTexture(const QString &path) {
-    const auto pTexture = _loadTextureFromFile(path);
-
-    if (!pTexture) {
-        return;
-    }
-
-    m_sceneMgr->setTextureImg(pTexture);
-}
-
-QImage *StateMgr::_loadTextureFromFile(const QString &path) {
-    const QImage image(path);
-
-    if (image.isNull()) {
-        qWarning() << "Failed to load image from path:" << path;
-        _showToast("Failed to load image");
-        return nullptr;
-    }
-
-    return new QImage(
-        image.scaled(RESOURCE_CONSTANTS::TEXTURE_IMAGE_SIZE, RESOURCE_CONSTANTS::TEXTURE_IMAGE_SIZE,
-                     Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+    /* current texture stays in use until the new one is ready */
+    m_resourceLoader->loadTexture(path);
 }
 
 void StateMgr::onLightColorChangedTriggered() {
@@ -399,11 +464,9 @@ void StateMgr::onLightColorChangedTriggered() {
 }
 
 void StateMgr::_loadNormalMap(const QString &path) {
-    const auto pTexture = _loadTextureFromFile(path);
-
-    if (!pTexture) {
-        return;
-    }
+    m_resourceLoader->loadNormalMap(path);
+}
 
-    m_sceneMgr->setNormalMap(pTexture);
+void StateMgr::_loadHeightMap(const QString &path, const float strength) {
+    m_resourceLoader->loadHeightMap(path, strength);
 }
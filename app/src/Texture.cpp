@@ -4,78 +4,356 @@
 
 #include "../include/Rendering/Texture.h"
 
-Texture::Texture(QObject *parent, const float ksCoef, const float kdCoef, const float mCoef,
-                 const QColor &lightColor, const bool useReflector, const float reflector_coef) : QObject(parent),
+Texture::Texture(QObject *parent, const float kaCoef, const float ksCoef, const float kdCoef, const float mCoef,
+                 const QColor &lightColor, const bool useReflector) : QObject(parent),
+    m_kaCoef(kaCoef),
     m_ksCoef(ksCoef),
     m_kdCoef(kdCoef),
     m_mCoef(mCoef),
     m_lightColor(lightColor),
-    m_reflectorCoef(reflector_coef),
     m_drawReflector(useReflector) {
 }
 
-QColor Texture::_applyLightToTriangleColor(const QColor &color, const QVector3D &normalVector,
-                                           const QVector3D &pos, const QVector3D &lightPos) const {
-    static constexpr QVector3D V(0, 0, 1);
+void Texture::prepareFrame(BitMap &bitMap, int16_t *zBuffer) {
+    const size_t zBufferSize = bitMap.width() * bitMap.height();
+    for (size_t z = 0; z < zBufferSize; ++z) {
+        zBuffer[z] = INT16_MIN;
+    }
+
+    bitMap.setWhiteAll();
+}
 
-    const QVector3D L1 = (lightPos - pos).normalized();
-    const QVector3D N = normalVector.normalized();
-    const float NdotL1 = QVector3D::dotProduct(N, L1);
-    const QVector3D R1 = (2.0f * NdotL1 * N - L1).normalized();
+void Texture::prepareShading(ShadingConstants &shading, const Mesh &mesh, const MeshArr &triangles,
+                             const std::vector<LightSource> &lightSources, const float scale, const int32_t width,
+                             const int32_t height, const bool useNormals, const bool useShadows,
+                             const ShadingModel model) {
+    /* normal map details are finer than any vertex */
+    Q_ASSERT(!useNormals || model == ShadingModel::PER_PIXEL);
+    Q_ASSERT(scale > 0.0f);
 
-    const float cos00 = std::max(0.0f, NdotL1);
-    const float cos10 = std::max(0.0f, QVector3D::dotProduct(V, R1));
-    const float cos1m0 = std::pow(cos10, m_mCoef);
+    std::vector<float3> positions{};
+    positions.reserve(lightSources.size());
 
-    const QVector3D lightPos2 = QVector3D(
-        -lightPos.x(), -lightPos.y(), lightPos.z());
+    for (const LightSource &source: lightSources) {
+        positions.push_back(source.position);
+    }
+
+    const std::vector<const ShadowMap *> shadowMaps = useShadows && m_useShadows
+                                                          ? _prepareShadowMaps(mesh, positions)
+                                                          : std::vector<const ShadowMap *>{};
 
-    const QVector3D L2 = (lightPos2 - pos).normalized();
-    const float NdotL2 = QVector3D::dotProduct(N, L2);
-    const QVector3D R2 = (2.0f * NdotL2 * N - L2).normalized();
+    shading.lightGrid.build(_createLights(lightSources, scale, shadowMaps), triangles, width, height);
+    shading.worldScale = 1.0f / scale;
+    shading.specularExponent = m_mCoef;
+    shading.ambient = m_kaCoef * _getLightColor();
+    shading.normalMap = nullptr;
+    shading.model = model;
+    shading.vertexLight.clear();
 
-    const float cos01 = std::max(0.0f, NdotL2);
-    const float cos11 = std::max(0.0f, QVector3D::dotProduct(V, R2));
-    const float cos1m1 = std::pow(cos11, m_mCoef);
+    if (useNormals) {
+        _prepareNormalMap(mesh);
 
-    QVector3D lightColors = QVector3D(
-                                static_cast<float>(m_lightColor.red()),
-                                static_cast<float>(m_lightColor.green()),
-                                static_cast<float>(m_lightColor.blue())) / 255.0f;
+        shading.normalMap = m_objectNormalMap;
+        shading.normalRotation = mesh.getRotationBasis();
+    }
 
-    QVector3D objColors = QVector3D(
-                              static_cast<float>(color.red()),
-                              static_cast<float>(color.green()),
-                              static_cast<float>(color.blue())) / 255.0f;
+    if (model == ShadingModel::PER_VERTEX) {
+        _computeVertexLights(shading, triangles);
+    }
+}
 
-    const float a1 = QVector3D::dotProduct(L1.normalized(), lightPos.normalized());
-    const float a2 = QVector3D::dotProduct(L2.normalized(), lightPos2.normalized());
+std::vector<const ShadowMap *> Texture::_prepareShadowMaps(const Mesh &mesh,
+                                                           const std::vector<float3> &positions) {
+    const auto t0 = std::chrono::steady_clock::now();
 
-    const float a1m = std::abs(std::pow(a1, m_reflectorCoef));
-    const float a2m = std::abs(std::pow(a2, m_reflectorCoef));
+    m_shadowMaps.resize(positions.size());
 
-    QVector3D resultColors{};
-    for (int i = 0; i < 3; ++i) {
-        const float left = m_kdCoef * lightColors[i] * objColors[i] * cos00;
-        const float right = m_ksCoef * lightColors[i] * objColors[i] * cos1m0;
+    std::vector<size_t> staleMaps{};
+    for (size_t idx = 0; idx < positions.size(); ++idx) {
+        if (!m_shadowMaps[idx]) {
+            m_shadowMaps[idx] = std::make_unique<ShadowMap>();
+        }
 
-        const float left1 = m_kdCoef * lightColors[i] * objColors[i] * cos01;
-        const float right1 = m_ksCoef * lightColors[i] * objColors[i] * cos1m1;
+        if (!m_shadowMaps[idx]->isValidFor(positions[idx], mesh.getRevision())) {
+            staleMaps.push_back(idx);
+        }
+    }
 
-        const float light = m_drawReflector
-                                ? (left + right) * a1m + (left1 + right1) * a2m
-                                : left + right + left1 + right1;
+    /* maps are independent - one task per map keeps the depth-only rasterizer free of synchronization */
+    ThreadPool::getInstance().parallelFor(0, staleMaps.size(), 1, [&](const size_t i) {
+        const size_t idx = staleMaps[i];
+        m_shadowMaps[idx]->build(positions[idx], mesh.getMeshArr(), mesh.getRevision());
+    });
 
-        resultColors[i] = std::clamp(light, 0.0f, 1.0f);
+    if (!staleMaps.empty()) {
+        const auto t1 = std::chrono::steady_clock::now();
+        qDebug() << "Time spent on shadow maps: " << (t1 - t0).count() << " ns, rebuilt " << staleMaps.size()
+                << " of " << positions.size();
     }
 
-    resultColors *= 255.0f;
+    std::vector<const ShadowMap *> result{};
+    result.reserve(m_shadowMaps.size());
 
-    return {
-        static_cast<int>(resultColors.x()),
-        static_cast<int>(resultColors.y()),
-        static_cast<int>(resultColors.z())
+    for (const auto &shadowMap: m_shadowMaps) {
+        result.push_back(shadowMap.get());
+    }
+
+    return result;
+}
+
+void Texture::_computeVertexLights(ShadingConstants &shading, const MeshArr &triangles) {
+    /* every vertex is shared by up to six triangles - light only one of its copies */
+    std::vector<const Vertex *> uniqueVertices{};
+
+    for (const auto &triangle: triangles) {
+        for (const auto &vertex: triangle) {
+            if (vertex.index >= uniqueVertices.size()) {
+                uniqueVertices.resize(vertex.index + 1, nullptr);
+            }
+
+            uniqueVertices[vertex.index] = &vertex;
+        }
+    }
+
+    shading.vertexLight.assign(uniqueVertices.size(), float3());
+
+    /* spot light culling is done per screen tile - vertices simply take all the lights */
+    const LightSet &lights = shading.lightGrid.lights();
+
+    ThreadPool::getInstance().parallelFor(0, uniqueVertices.size(), VERTICES_PER_TASK, [&](const size_t idx) {
+        if (const Vertex *vertex = uniqueVertices[idx]) {
+            shading.vertexLight[idx] = fmadd(shading.ambient, vertex->ao,
+                                             _computeLight(vertex->rotatedNormal, vertex->rotatedPosition, lights,
+                                                           shading));
+        }
+    });
+}
+
+void Texture::_prepareNormalMap(const Mesh &mesh) {
+    Q_ASSERT(m_normalMap != nullptr);
+
+    if (!m_objectNormalMap || m_bakedControlPoints != mesh.getControlPoints()) {
+        const auto t0 = std::chrono::steady_clock::now();
+
+        m_bakedControlPoints = mesh.getControlPoints();
+        m_objectNormalMap = std::shared_ptr<const NormalMap>(
+            NormalMap::bakeObjectSpace(*m_normalMap, m_bakedControlPoints));
+
+        const auto t1 = std::chrono::steady_clock::now();
+        qDebug() << "Time spent on baking normal map: " << (t1 - t0).count() << " ns";
+    }
+}
+
+void Texture::finishFrame(QPixmap &pixmap, BitMap &bitMap, int16_t *zBuffer, const MeshArr &triangles,
+                          const MeshArr &figure, const Mesh &mesh, const std::chrono::nanoseconds frameTime) const {
+    const auto t0 = std::chrono::steady_clock::now();
+
+    if (m_drawNet) {
+        for (const auto &triangle: triangles) {
+            for (size_t i = 0; i < 3; i++) {
+                const auto &v1 = triangle[i].rotatedPosition;
+                const auto &v2 = triangle[(i + 1) % 3].rotatedPosition;
+
+                _drawLineOwn(v1, v2, bitMap, zBuffer);
+            }
+        }
+    }
+
+    size_t idx = 0;
+    for (const auto &triangle: figure) {
+        const QColor color = mesh.getFigureColor(idx++);
+        colorFigure<false>(bitMap, zBuffer, color, triangle, {});
+
+        for (size_t i = 0; i < 3; i++) {
+            const auto &v1 = triangle[i].rotatedPosition;
+            const auto &v2 = triangle[(i + 1) % 3].rotatedPosition;
+
+            _drawLineOwn(v1, v2, bitMap, zBuffer);
+        }
+    }
+
+    /* preview passes are rendered in lower resolution - stretch them over the whole pixmap */
+    bitMap.dropToPixMap(pixmap);
+
+    const auto t1 = std::chrono::steady_clock::now();
+    const auto t = frameTime + (t1 - t0);
+
+    qDebug() << "Time spent on drawing texture: " << t.count() << " ns";
+
+    const auto tm = std::chrono::duration_cast<std::chrono::milliseconds>(t);
+
+    QPainter painter(&pixmap);
+
+    painter.setPen(QPen(Qt::black, 2));
+
+    QFont font{};
+    font.setFamily("Courier");
+    font.setPointSize(UI_CONSTANTS::DEFAULT_FPS_SIZE);
+    font.setBold(true);
+    painter.setFont(font);
+    painter.setPen(Qt::black);
+    painter.setBrush(Qt::black);
+
+    painter.drawText(0, 20, "Fps: " + QString::number(1000.0 / static_cast<double>(tm.count())));
+}
+
+LightSet Texture::_createLights(const std::vector<LightSource> &lightSources, const float scale,
+                                const std::vector<const ShadowMap *> &shadowMaps) const {
+    LightSet lights{};
+    for (size_t idx = 0; idx < lightSources.size(); ++idx) {
+        const LightSource &source = lightSources[idx];
+
+        lights.addLight({
+            scale * source.position,
+            m_kdCoef * source.color,
+            m_ksCoef * source.color,
+            /* reflectors point at the scene origin */
+            -normalize(source.position),
+            m_drawReflector ? source.coneExponent : 0.0f,
+            idx < shadowMaps.size() ? shadowMaps[idx] : nullptr
+        });
+    }
+
+    return lights;
+}
+
+float3 Texture::_getLightColor() const {
+    return float3(
+               static_cast<float>(m_lightColor.red()),
+               static_cast<float>(m_lightColor.green()),
+               static_cast<float>(m_lightColor.blue())) / 255.0f;
+}
+
+float3 Texture::_computeLight(const float3 &normalVector, const float3 &pos, const LightSet &lights,
+                              const ShadingConstants &shading) {
+    const float nx = normalVector.x;
+    const float ny = normalVector.y;
+    const float nz = normalVector.z;
+
+    const float px = pos.x;
+    const float py = pos.y;
+    const float pz = pos.z;
+
+    const float vx = shading.viewDir.x;
+    const float vy = shading.viewDir.y;
+    const float vz = shading.viewDir.z;
+    const float NdotV = dot(normalVector, shading.viewDir);
+
+    const float specularExponent = shading.specularExponent;
+    const size_t count = lights.size();
+
+    const float *posX = lights.posX();
+    const float *posY = lights.posY();
+    const float *posZ = lights.posZ();
+    const float *diffuseR = lights.diffuseR();
+    const float *diffuseG = lights.diffuseG();
+    const float *diffuseB = lights.diffuseB();
+    const float *specularR = lights.specularR();
+    const float *specularG = lights.specularG();
+    const float *specularB = lights.specularB();
+    const float *dirX = lights.dirX();
+    const float *dirY = lights.dirY();
+    const float *dirZ = lights.dirZ();
+    const float *coneExponent = lights.coneExponent();
+    const ShadowMap *const *shadowMap = lights.shadowMap();
+
+    /* light directions are needed twice - first to find out whether any light faces the pixel at all */
+    float lx[LIGHTING_CONSTANTS::MAX_LIGHT_COUNT];
+    float ly[LIGHTING_CONSTANTS::MAX_LIGHT_COUNT];
+    float lz[LIGHTING_CONSTANTS::MAX_LIGHT_COUNT];
+    float NdotL[LIGHTING_CONSTANTS::MAX_LIGHT_COUNT];
+    float maxNdotL = 0.0f;
+
+    Q_ASSERT(count <= LIGHTING_CONSTANTS::MAX_LIGHT_COUNT);
+
+#pragma omp simd reduction(max:maxNdotL)
+    for (size_t i = 0; i < count; ++i) {
+        const float dx = posX[i] - px;
+        const float dy = posY[i] - py;
+        const float dz = posZ[i] - pz;
+        const float invLength = 1.0f / std::sqrt(dx * dx + dy * dy + dz * dz);
+
+        lx[i] = dx * invLength;
+        ly[i] = dy * invLength;
+        lz[i] = dz * invLength;
+        NdotL[i] = nx * lx[i] + ny * ly[i] + nz * lz[i];
+
+        maxNdotL = std::max(maxNdotL, NdotL[i]);
+    }
+
+    /* every light is behind the surface - no diffuse nor specular contribution */
+    if (maxNdotL <= 0.0f) {
+        return {};
+    }
+
+    /* shadow lookups gather from the maps - kept out of the vectorized loop, skipped for unlit sides */
+    float visibility[LIGHTING_CONSTANTS::MAX_LIGHT_COUNT];
+    const float3 worldPos = shading.worldScale * pos;
+
+    for (size_t i = 0; i < count; ++i) {
+        visibility[i] = shadowMap[i] && NdotL[i] > 0.0f ? shadowMap[i]->visibility(worldPos) : 1.0f;
+    }
+
+    float red = 0.0f;
+    float green = 0.0f;
+    float blue = 0.0f;
+
+#pragma omp simd reduction(+:red, green, blue)
+    for (size_t i = 0; i < count; ++i) {
+        /* R = 2(N.L)N - L is never formed, only its projection onto V */
+        const float VdotR = 2.0f * NdotL[i] * NdotV - (lx[i] * vx + ly[i] * vy + lz[i] * vz);
+        const float coneCos = -(lx[i] * dirX[i] + ly[i] * dirY[i] + lz[i] * dirZ[i]);
+
+        /* lights behind the surface contribute nothing, specular included */
+        const float isFacing = NdotL[i] > 0.0f ? 1.0f : 0.0f;
+        const float cosSpecular = FastMath::pow01(VdotR, specularExponent);
+        const float cone = coneExponent[i] > 0.0f ? FastMath::pow01(coneCos, coneExponent[i]) : 1.0f;
+        const float weight = isFacing * cone * visibility[i];
+
+        red += (diffuseR[i] * NdotL[i] + specularR[i] * cosSpecular) * weight;
+        green += (diffuseG[i] * NdotL[i] + specularG[i] * cosSpecular) * weight;
+        blue += (diffuseB[i] * NdotL[i] + specularB[i] * cosSpecular) * weight;
+    }
+
+    return {red, green, blue};
+}
+
+QRgb Texture::_applyLightToColor(const QRgb color, const float3 &light) {
+    const auto channel = [](const int objColor, const float light) {
+        return static_cast<int>(std::clamp(static_cast<float>(objColor) / 255.0f * light, 0.0f, 1.0f) * 255.0f);
     };
+
+    return qRgb(channel(qRed(color), light.x), channel(qGreen(color), light.y), channel(qBlue(color), light.z));
+}
+
+std::array<float, 3> Texture::_computeBarycentric(const float3 &pos, const Triangle &triangle,
+                                                  const _drawData &drawData) {
+    const float3 v2 = pos - triangle[0].rotatedPosition;
+
+    const float d20 = dot(v2, drawData.v0);
+    const float d21 = dot(v2, drawData.v1);
+
+    const float denom = drawData.d00 * drawData.d11 - drawData.d01 * drawData.d01;
+    const float v = (drawData.d11 * d20 - drawData.d01 * d21) / denom;
+    const float w = (drawData.d00 * d21 - drawData.d01 * d20) / denom;
+    const float u = 1.0f - v - w;
+
+    return {u, v, w};
+}
+
+float3 Texture::_interpolateVertexLight(const std::array<float, 3> &weights, const Triangle &triangle,
+                                       const ShadingConstants &shading) {
+    const auto [u, v, w] = weights;
+
+    /* vertexLight is sized from the tessellation the pass was prepared for */
+    Q_ASSERT(triangle[0].index < shading.vertexLight.size() &&
+        triangle[1].index < shading.vertexLight.size() &&
+        triangle[2].index < shading.vertexLight.size());
+
+    /* pixels outside the triangle get extrapolated - clamped later with the final color */
+    return u * shading.vertexLight[triangle[0].index] +
+           v * shading.vertexLight[triangle[1].index] +
+           w * shading.vertexLight[triangle[2].index];
 }
 
 Texture::_drawData Texture::_preprocess(const Triangle &triangle) {
@@ -84,18 +362,45 @@ Texture::_drawData Texture::_preprocess(const Triangle &triangle) {
     result.v0 = triangle[1].rotatedPosition - triangle[0].rotatedPosition;
     result.v1 = triangle[2].rotatedPosition - triangle[0].rotatedPosition;
 
-    result.d00 = QVector3D::dotProduct(result.v0, result.v0);
-    result.d01 = QVector3D::dotProduct(result.v0, result.v1);
-    result.d11 = QVector3D::dotProduct(result.v1, result.v1);
+    result.d00 = dot(result.v0, result.v0);
+    result.d01 = dot(result.v0, result.v1);
+    result.d11 = dot(result.v1, result.v1);
 
     return result;
 }
 
-void Texture::_drawLineOwn(const QVector3D &from, const QVector3D &to, BitMap &bitMap, int16_t *zBuffer) {
-    int x1 = int(from.x() + bitMap.width() / 2.0);
-    int y1 = int(from.y() + bitMap.height() / 2.0);
-    int x2 = int(to.x() + bitMap.width() / 2.0);
-    int y2 = int(to.y() + bitMap.height() / 2.0);
+UvGradient Texture::_computeUvGradient(const Triangle &triangle) {
+    const float x1 = triangle[1].rotatedPosition.x - triangle[0].rotatedPosition.x;
+    const float y1 = triangle[1].rotatedPosition.y - triangle[0].rotatedPosition.y;
+    const float x2 = triangle[2].rotatedPosition.x - triangle[0].rotatedPosition.x;
+    const float y2 = triangle[2].rotatedPosition.y - triangle[0].rotatedPosition.y;
+
+    const float det = x1 * y2 - x2 * y1;
+
+    /* edge-on triangle - covers at most a line of pixels, base level is fine */
+    if (std::abs(det) < 1e-6f) {
+        return {};
+    }
+
+    const float du1 = triangle[1].u - triangle[0].u;
+    const float du2 = triangle[2].u - triangle[0].u;
+    const float dv1 = triangle[1].v - triangle[0].v;
+    const float dv2 = triangle[2].v - triangle[0].v;
+
+    /* same values as finite differences over any 2x2 pixel quad inside the triangle */
+    return {
+        (du1 * y2 - du2 * y1) / det,
+        (dv1 * y2 - dv2 * y1) / det,
+        (du2 * x1 - du1 * x2) / det,
+        (dv2 * x1 - dv1 * x2) / det,
+    };
+}
+
+void Texture::_drawLineOwn(const float3 &from, const float3 &to, BitMap &bitMap, int16_t *zBuffer) {
+    int x1 = int(from.x + bitMap.width() / 2.0);
+    int y1 = int(from.y + bitMap.height() / 2.0);
+    int x2 = int(to.x + bitMap.width() / 2.0);
+    int y2 = int(to.y + bitMap.height() / 2.0);
 
     int dx = abs(x2 - x1);
     int dy = abs(y2 - y1);
@@ -103,14 +408,14 @@ void Texture::_drawLineOwn(const QVector3D &from, const QVector3D &to, BitMap &b
     int sy = y1 < y2 ? 1 : -1;
     int err = dx - dy;
 
-    float z1 = from.z();
-    float z2 = to.z();
+    float z1 = from.z;
+    float z2 = to.z;
 
     while (true) {
         if (x1 >= 0 && y1 >= 0 && x1 < bitMap.width() && y1 < bitMap.height()) {
             float t = (dx > dy) ?
-                     float(x1 - (from.x() + bitMap.width() / 2.0)) / (to.x() - from.x()) :
-                     float(y1 - (from.y() + bitMap.height() / 2.0)) / (to.y() - from.y());
+                     float(x1 - (from.x + bitMap.width() / 2.0)) / (to.x - from.x) :
+                     float(y1 - (from.y + bitMap.height() / 2.0)) / (to.y - from.y);
             float z = z1 + t * (z2 - z1) + 2.0;
 
             auto zRounded = static_cast<int16_t>(std::floor(z));
@@ -127,26 +432,26 @@ void Texture::_drawLineOwn(const QVector3D &from, const QVector3D &to, BitMap &b
     }
 }
 
-QVector3D Texture::_findNormal(const QVector3D &pos, const Triangle &triangle) const {
-    QVector3D v0 = triangle[1].position - triangle[0].position;
-    QVector3D v1 = triangle[2].position - triangle[0].position;
-    QVector3D v2 = pos - triangle[0].position;
+float3 Texture::_findNormal(const float3 &pos, const Triangle &triangle) const {
+    float3 v0 = triangle[1].position - triangle[0].position;
+    float3 v1 = triangle[2].position - triangle[0].position;
+    float3 v2 = pos - triangle[0].position;
 
-    float d00 = QVector3D::dotProduct(v0, v0);
-    float d01 = QVector3D::dotProduct(v0, v1);
-    float d11 = QVector3D::dotProduct(v1, v1);
-    float d20 = QVector3D::dotProduct(v2, v0);
-    float d21 = QVector3D::dotProduct(v2, v1);
+    float d00 = dot(v0, v0);
+    float d01 = dot(v0, v1);
+    float d11 = dot(v1, v1);
+    float d20 = dot(v2, v0);
+    float d21 = dot(v2, v1);
 
     float denom = d00 * d11 - d01 * d01;
     float v = (d11 * d20 - d01 * d21) / denom;
     float w = (d00 * d21 - d01 * d20) / denom;
     float u = 1.0f - v - w;
 
-    QVector3D interpolatedNormal =
+    float3 interpolatedNormal =
         triangle[0].normal * u +
         triangle[1].normal * v +
         triangle[2].normal * w;
 
-    return interpolatedNormal.normalized();
+    return normalize(interpolatedNormal);
 }
@@ -0,0 +1,291 @@
+//
+// Created by Jlisowskyy on 11/13/24.
+//
+
+/* internal includes */
+#include "../include/ManagingObjects/TextureCache.h"
+#include "../include/Rendering/TextureImage.h"
+#include "../include/Rendering/NormalMap.h"
+
+/* external includes */
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+TextureCache::TextureCache(const QString &directory) : m_directory(directory) {
+    if (!m_directory.isEmpty() && !QDir().mkpath(m_directory)) {
+        qWarning() << "Failed to create texture cache directory:" << m_directory;
+        m_directory.clear();
+    }
+}
+
+QString TextureCache::defaultDirectory() {
+    const QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    return base.isEmpty() ? QString() : QDir(base).filePath(RESOURCE_CONSTANTS::TEXTURE_CACHE_DIR);
+}
+
+QString TextureCache::makeKey(QFile &source) {
+    static constexpr int64_t SAMPLE_BYTES = RESOURCE_CONSTANTS::TEXTURE_CACHE_SAMPLE_BYTES;
+
+    const QFileInfo info(source);
+    const QDateTime modified = info.lastModified();
+    const qint64 size = source.size();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    /* middle of the file is skipped only when path, size and time tell the edits apart - sources without time and
+     * small ones gain nothing from it */
+    if (!modified.isValid() || size <= 2 * SAMPLE_BYTES) {
+        hash.addData(QByteArray("content"));
+        source.seek(0);
+        hash.addData(&source);
+    } else {
+        hash.addData(QByteArray("fingerprint"));
+        hash.addData(info.absoluteFilePath().toUtf8());
+        hash.addData(QByteArray::number(size));
+        hash.addData(QByteArray::number(modified.toMSecsSinceEpoch()));
+
+        source.seek(0);
+        hash.addData(source.read(SAMPLE_BYTES));
+        source.seek(size - SAMPLE_BYTES);
+        hash.addData(source.read(SAMPLE_BYTES));
+    }
+
+    source.seek(0);
+    return QString::fromLatin1(hash.result().toHex()) + "_" + QString::number(RESOURCE_CONSTANTS::TEXTURE_IMAGE_SIZE);
+}
+
+template<>
+TextureImage *TextureCache::load<TextureImage>(const QString &key) const {
+    const _FileHeader *header;
+    qint64 size;
+    auto file = _mapEntry(key, _EntryKind::TEXTURE, &header, &size);
+
+    if (!file) {
+        return nullptr;
+    }
+
+    const auto layout = static_cast<TexelLayout>(header->layout);
+    const size_t levelsOffset = sizeof(_FileHeader);
+
+    /* a valid pyramid halves down to 1x1 - any other level count means a damaged header */
+    if (!_isValidExtent(header->width, header->height) ||
+        header->levelCount != _getMipLevelCount(header->width, header->height)) {
+        return _dropCorrupted(*file);
+    }
+
+    const size_t texelsOffset = _alignPayload(levelsOffset + header->levelCount * sizeof(TextureImage::_MipLevel));
+
+    if (texelsOffset > static_cast<size_t>(size) ||
+        header->texelCount != (static_cast<size_t>(size) - texelsOffset) / sizeof(QRgb) ||
+        texelsOffset + header->texelCount * sizeof(QRgb) != static_cast<size_t>(size)) {
+        return _dropCorrupted(*file);
+    }
+
+    const auto *base = reinterpret_cast<const uchar *>(header);
+    std::vector<TextureImage::_MipLevel> levels(header->levelCount);
+    std::memcpy(levels.data(), base + levelsOffset, header->levelCount * sizeof(TextureImage::_MipLevel));
+
+    /* every descriptor must match the one TextureImage would allocate - samplers index the mapping unchecked */
+    size_t offset = 0;
+    int32_t width = header->width;
+    int32_t height = header->height;
+
+    for (auto &level: levels) {
+        if (level.offset != offset || level.width != width || level.height != height ||
+            level.stride != TexelAddressing::stride(layout, width)) {
+            return _dropCorrupted(*file);
+        }
+
+        level.xScale = static_cast<float>(width - 1);
+        level.yScale = static_cast<float>(height - 1);
+
+        offset += TexelAddressing::size(layout, width, height);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+
+    if (offset != header->texelCount) {
+        return _dropCorrupted(*file);
+    }
+
+    auto *image = new TextureImage();
+
+    image->m_layout = layout;
+    image->m_levels = std::move(levels);
+    image->m_data = reinterpret_cast<const QRgb *>(base + texelsOffset);
+    image->m_mappedFile = std::move(file);
+
+    return image;
+}
+
+template<>
+NormalMap *TextureCache::load<NormalMap>(const QString &key) const {
+    const _FileHeader *header;
+    qint64 size;
+    auto file = _mapEntry(key, _EntryKind::NORMAL_MAP, &header, &size);
+
+    if (!file) {
+        return nullptr;
+    }
+
+    const auto layout = static_cast<TexelLayout>(header->layout);
+    const size_t texelsOffset = _alignPayload(sizeof(_FileHeader));
+
+    if (!_isValidExtent(header->width, header->height) ||
+        header->texelCount != TexelAddressing::size(layout, header->width, header->height) ||
+        texelsOffset > static_cast<size_t>(size) ||
+        header->texelCount != (static_cast<size_t>(size) - texelsOffset) / sizeof(NormalMap::PackedNormal) ||
+        texelsOffset + header->texelCount * sizeof(NormalMap::PackedNormal) != static_cast<size_t>(size)) {
+        return _dropCorrupted(*file);
+    }
+
+    const auto *base = reinterpret_cast<const uchar *>(header);
+    auto *normalMap = new NormalMap();
+
+    normalMap->m_width = header->width;
+    normalMap->m_height = header->height;
+    normalMap->m_layout = layout;
+    normalMap->m_stride = TexelAddressing::stride(normalMap->m_layout, header->width);
+    normalMap->m_xScale = static_cast<float>(header->width - 1);
+    normalMap->m_yScale = static_cast<float>(header->height - 1);
+    normalMap->m_data = reinterpret_cast<const NormalMap::PackedNormal *>(base + texelsOffset);
+    normalMap->m_mappedFile = std::move(file);
+
+    return normalMap;
+}
+
+void TextureCache::store(const QString &key, const TextureImage &image) const {
+    Q_ASSERT(!image.m_mappedFile);
+
+    _FileHeader header = _makeHeader(_EntryKind::TEXTURE);
+    header.layout = static_cast<uint32_t>(image.m_layout);
+    header.width = image.width();
+    header.height = image.height();
+    header.levelCount = static_cast<uint32_t>(image.m_levels.size());
+    header.texelCount = image.m_texels.size();
+
+    const size_t levelsSize = image.m_levels.size() * sizeof(TextureImage::_MipLevel);
+    const size_t texelsOffset = _alignPayload(sizeof(_FileHeader) + levelsSize) - sizeof(_FileHeader);
+
+    QByteArray payload(static_cast<qsizetype>(texelsOffset + image.m_texels.size() * sizeof(QRgb)), '\0');
+    std::memcpy(payload.data(), image.m_levels.data(), levelsSize);
+    std::memcpy(payload.data() + texelsOffset, image.m_texels.data(), image.m_texels.size() * sizeof(QRgb));
+
+    _writeEntry(key, header, payload);
+}
+
+void TextureCache::store(const QString &key, const NormalMap &normalMap) const {
+    Q_ASSERT(!normalMap.m_mappedFile);
+
+    _FileHeader header = _makeHeader(_EntryKind::NORMAL_MAP);
+    header.layout = static_cast<uint32_t>(normalMap.m_layout);
+    header.width = normalMap.m_width;
+    header.height = normalMap.m_height;
+    header.texelCount = normalMap.m_texels.size();
+
+    const size_t texelsOffset = _alignPayload(sizeof(_FileHeader)) - sizeof(_FileHeader);
+    const size_t texelsSize = normalMap.m_texels.size() * sizeof(NormalMap::PackedNormal);
+
+    QByteArray payload(static_cast<qsizetype>(texelsOffset + texelsSize), '\0');
+    std::memcpy(payload.data() + texelsOffset, normalMap.m_texels.data(), texelsSize);
+
+    _writeEntry(key, header, payload);
+}
+
+QString TextureCache::_entryPath(const QString &key, const _EntryKind kind) const {
+    return QDir(m_directory).filePath(key + (kind == _EntryKind::TEXTURE ? ".tex" : ".nrm"));
+}
+
+std::unique_ptr<QFile> TextureCache::_mapEntry(const QString &key, const _EntryKind kind,
+                                               const _FileHeader **header, qint64 *size) const {
+    if (m_directory.isEmpty()) {
+        return nullptr;
+    }
+
+    auto file = std::make_unique<QFile>(_entryPath(key, kind));
+    if (!file->open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+
+    *size = file->size();
+    if (*size < static_cast<qint64>(sizeof(_FileHeader))) {
+        return nullptr;
+    }
+
+    /* mapping stays valid as long as the QFile object lives */
+    const uchar *data = file->map(0, *size);
+    if (!data) {
+        return nullptr;
+    }
+
+    const auto *mappedHeader = reinterpret_cast<const _FileHeader *>(data);
+    if (std::memcmp(mappedHeader->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        mappedHeader->version != RESOURCE_CONSTANTS::TEXTURE_CACHE_VERSION ||
+        mappedHeader->kind != kind ||
+        mappedHeader->layout > static_cast<uint32_t>(TexelLayout::TILED_4X4)) {
+        qWarning() << "Dropping stale texture cache entry:" << file->fileName();
+        return nullptr;
+    }
+
+    *header = mappedHeader;
+    return file;
+}
+
+std::nullptr_t TextureCache::_dropCorrupted(const QFile &file) {
+    qWarning() << "Dropping corrupted texture cache entry:" << file.fileName();
+    return nullptr;
+}
+
+bool TextureCache::_isValidExtent(const int32_t width, const int32_t height) {
+    return width > 0 && height > 0 && width <= MAX_EXTENT && height <= MAX_EXTENT;
+}
+
+uint32_t TextureCache::_getMipLevelCount(int32_t width, int32_t height) {
+    uint32_t count = 1;
+
+    while (width > 1 || height > 1) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        ++count;
+    }
+
+    return count;
+}
+
+void TextureCache::_writeEntry(const QString &key, const _FileHeader &header, const QByteArray &payload) const {
+    if (m_directory.isEmpty()) {
+        return;
+    }
+
+    /* written to temporary file and renamed - concurrent readers never see partial entries */
+    QSaveFile file(_entryPath(key, header.kind));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open texture cache entry for writing:" << file.fileName();
+        return;
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(payload);
+
+    if (!file.commit()) {
+        qWarning() << "Failed to write texture cache entry:" << file.fileName();
+    }
+}
+
+TextureCache::_FileHeader TextureCache::_makeHeader(const _EntryKind kind) {
+    _FileHeader header{};
+
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = RESOURCE_CONSTANTS::TEXTURE_CACHE_VERSION;
+    header.kind = kind;
+
+    return header;
+}
@@ -0,0 +1,207 @@
+//
+// Created by Jlisowskyy on 11/12/24.
+//
+
+/* internal includes */
+#include "../include/Rendering/TextureImage.h"
+#include "../include/ManagingObjects/ThreadPool.h"
+
+/* external includes */
+#include <algorithm>
+#include <cstring>
+
+TextureImage::TextureImage(const QImage &image, const TexelLayout layout) : m_layout(layout) {
+    Q_ASSERT(!image.isNull());
+
+    const int32_t width = image.width();
+    const int32_t height = image.height();
+
+    const QImage converted = image.convertToFormat(QImage::Format_ARGB32);
+    const _MipLevel base = _allocateLevel(width, height);
+
+    for (int32_t y = 0; y < height; ++y) {
+        const auto *row = reinterpret_cast<const QRgb *>(converted.constScanLine(y));
+
+        for (int32_t x = 0; x < width;) {
+            const int32_t count = TexelAddressing::runLength(m_layout, width, x);
+            std::memcpy(m_texels.data() + _texelIndex(base, x, y), row + x, sizeof(QRgb) * count);
+            x += count;
+        }
+    }
+
+    m_levels.push_back(base);
+    _buildMipPyramid();
+}
+
+TextureImage::_MipLevel TextureImage::_allocateLevel(const int32_t width, const int32_t height) {
+    const _MipLevel level{
+        m_texels.size(), width, height, TexelAddressing::stride(m_layout, width),
+        static_cast<float>(width - 1), static_cast<float>(height - 1)
+    };
+
+    m_texels.resize(m_texels.size() + TexelAddressing::size(m_layout, width, height));
+    m_data = m_texels.data();
+
+    return level;
+}
+
+void TextureImage::_buildMipPyramid() {
+    /* reserve whole pyramid upfront - at most 1/3 of the base level plus tile padding */
+    m_texels.reserve(m_texels.size() + m_texels.size() / 3 +
+                     64 * TexelAddressing::TILE_SIZE * TexelAddressing::TILE_SIZE);
+
+    while (m_levels.back().width > 1 || m_levels.back().height > 1) {
+        const _MipLevel src = m_levels.back();
+        const _MipLevel dst = _allocateLevel(std::max(1, src.width / 2), std::max(1, src.height / 2));
+
+        /* 2x2 box filter, odd edges are clamped */
+        static constexpr size_t ROWS_PER_TASK = 8;
+        ThreadPool::getInstance().parallelFor(0, dst.height, ROWS_PER_TASK, [&](const size_t row) {
+            const auto y = static_cast<int32_t>(row);
+            const int32_t y0 = std::min(2 * y, src.height - 1);
+            const int32_t y1 = std::min(2 * y + 1, src.height - 1);
+
+            for (int32_t x = 0; x < dst.width; ++x) {
+                const int32_t x0 = std::min(2 * x, src.width - 1);
+                const int32_t x1 = std::min(2 * x + 1, src.width - 1);
+
+                const QRgb texels[4]{
+                    _texelAt(src, x0, y0), _texelAt(src, x1, y0), _texelAt(src, x0, y1), _texelAt(src, x1, y1)
+                };
+
+                uint32_t result = 0;
+                for (uint32_t shift = 0; shift < 32; shift += 8) {
+                    uint32_t sum = 2;
+                    for (const QRgb texel: texels) {
+                        sum += (texel >> shift) & 0xFF;
+                    }
+                    result |= (sum / 4) << shift;
+                }
+
+                m_texels[_texelIndex(dst, x, y)] = result;
+            }
+        });
+
+        m_levels.push_back(dst);
+    }
+}
+
+void TextureImage::sampleTrilinearBatch(const float *u, const float *v, const float lod, QRgb *out,
+                                        const size_t count) const {
+    Q_ASSERT(count <= SAMPLE_BATCH_SIZE);
+
+    /* magnification - NaN lod falls here as well */
+    if (!(lod > 0.0f)) {
+        _sampleBilinearBatch(m_levels.front(), u, v, out, count);
+        return;
+    }
+
+    const auto maxLevel = static_cast<float>(m_levels.size() - 1);
+    if (lod >= maxLevel) {
+        _sampleBilinearBatch(m_levels.back(), u, v, out, count);
+        return;
+    }
+
+    const auto level = static_cast<size_t>(lod);
+    const float weight = lod - static_cast<float>(level);
+
+    QRgb coarse[SAMPLE_BATCH_SIZE];
+    _sampleBilinearBatch(m_levels[level], u, v, out, count);
+    _sampleBilinearBatch(m_levels[level + 1], u, v, coarse, count);
+
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = _lerpColor(out[i], coarse[i], weight);
+    }
+}
+
+#ifdef __AVX2__
+
+__m256i TextureImage::_texelIndex8(const TexelLayout layout, const __m256i stride, const __m256i x,
+                                   const __m256i y) {
+    if (layout == TexelLayout::ROW_MAJOR) {
+        return _mm256_add_epi32(_mm256_mullo_epi32(y, stride), x);
+    }
+
+    const __m256i mask = _mm256_set1_epi32(TexelAddressing::TILE_MASK);
+    const __m256i tile = _mm256_add_epi32(
+        _mm256_mullo_epi32(_mm256_srli_epi32(y, TexelAddressing::TILE_SHIFT), stride),
+        _mm256_srli_epi32(x, TexelAddressing::TILE_SHIFT)
+    );
+
+    return _mm256_add_epi32(
+        _mm256_add_epi32(_mm256_slli_epi32(tile, 2 * TexelAddressing::TILE_SHIFT),
+                         _mm256_slli_epi32(_mm256_and_si256(y, mask), TexelAddressing::TILE_SHIFT)),
+        _mm256_and_si256(x, mask)
+    );
+}
+
+__m256i TextureImage::_lerpChannel8(const __m256i c0, const __m256i c1, const __m256i c2, const __m256i c3,
+                                    const __m256 wx, const __m256 wy, const int shift) {
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const auto channel = [&](const __m256i c) {
+        return _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(c, shift), byteMask));
+    };
+
+    const __m256 f0 = channel(c0);
+    const __m256 f2 = channel(c2);
+    const __m256 top = _mm256_add_ps(f0, _mm256_mul_ps(_mm256_sub_ps(channel(c1), f0), wx));
+    const __m256 bottom = _mm256_add_ps(f2, _mm256_mul_ps(_mm256_sub_ps(channel(c3), f2), wx));
+    const __m256 result = _mm256_add_ps(_mm256_add_ps(top, _mm256_mul_ps(_mm256_sub_ps(bottom, top), wy)),
+                                        _mm256_set1_ps(0.5f));
+
+    return _mm256_slli_epi32(_mm256_cvttps_epi32(result), shift);
+}
+
+#endif
+
+void TextureImage::_sampleBilinearBatch(const _MipLevel &level, const float *u, const float *v, QRgb *out,
+                                        const size_t count) const {
+    size_t i = 0;
+
+#ifdef __AVX2__
+    const auto *texels = reinterpret_cast<const int *>(m_data + level.offset);
+
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zeroPs = _mm256_setzero_ps();
+    const __m256 xScale = _mm256_set1_ps(level.xScale);
+    const __m256 yScale = _mm256_set1_ps(level.yScale);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i step = _mm256_set1_epi32(1);
+    const __m256i xMax = _mm256_set1_epi32(level.width - 1);
+    const __m256i yMax = _mm256_set1_epi32(level.height - 1);
+    const __m256i stride = _mm256_set1_epi32(level.stride);
+
+    for (; i + 8 <= count; i += 8) {
+        /* TexelAddressing::clampCoord - max_ps returns its second operand for NaN lanes */
+        const __m256 fx = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(v + i), xScale), zeroPs),
+                                        xScale);
+        const __m256 fy = _mm256_min_ps(
+            _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(one, _mm256_loadu_ps(u + i)), yScale), zeroPs), yScale);
+
+        /* clamping the indices again keeps the gathers in bounds whatever the rounding */
+        const __m256i x0 = _mm256_max_epi32(zero, _mm256_min_epi32(_mm256_cvttps_epi32(fx), xMax));
+        const __m256i y0 = _mm256_max_epi32(zero, _mm256_min_epi32(_mm256_cvttps_epi32(fy), yMax));
+        const __m256i x1 = _mm256_min_epi32(_mm256_add_epi32(x0, step), xMax);
+        const __m256i y1 = _mm256_min_epi32(_mm256_add_epi32(y0, step), yMax);
+
+        const __m256 wx = _mm256_sub_ps(fx, _mm256_cvtepi32_ps(x0));
+        const __m256 wy = _mm256_sub_ps(fy, _mm256_cvtepi32_ps(y0));
+
+        const __m256i c0 = _mm256_i32gather_epi32(texels, _texelIndex8(m_layout, stride, x0, y0), 4);
+        const __m256i c1 = _mm256_i32gather_epi32(texels, _texelIndex8(m_layout, stride, x1, y0), 4);
+        const __m256i c2 = _mm256_i32gather_epi32(texels, _texelIndex8(m_layout, stride, x0, y1), 4);
+        const __m256i c3 = _mm256_i32gather_epi32(texels, _texelIndex8(m_layout, stride, x1, y1), 4);
+
+        const __m256i result = _mm256_or_si256(
+            _mm256_or_si256(_lerpChannel8(c0, c1, c2, c3, wx, wy, 24), _lerpChannel8(c0, c1, c2, c3, wx, wy, 16)),
+            _mm256_or_si256(_lerpChannel8(c0, c1, c2, c3, wx, wy, 8), _lerpChannel8(c0, c1, c2, c3, wx, wy, 0))
+        );
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), result);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        out[i] = _sampleBilinear(level, u[i], v[i]);
+    }
+}
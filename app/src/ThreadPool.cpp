@@ -0,0 +1,212 @@
+//
+// Created by Jlisowskyy on 11/18/24.
+//
+
+/* internal includes */
+#include "../include/ManagingObjects/ThreadPool.h"
+
+/* external includes */
+#include <QtGlobal>
+#include <algorithm>
+#include <iterator>
+
+thread_local ThreadPool *ThreadPool::s_workerPool{};
+thread_local size_t ThreadPool::s_dequeIdx{};
+thread_local size_t ThreadPool::s_loopDepth{};
+
+ThreadPool::ThreadPool(const size_t threadCount) {
+    _start(threadCount);
+}
+
+ThreadPool::~ThreadPool() {
+    _stop();
+}
+
+ThreadPool &ThreadPool::getInstance() {
+    static ThreadPool pool(THREAD_CONSTANTS::DEFAULT_THREAD_COUNT);
+    return pool;
+}
+
+void ThreadPool::resize(const size_t threadCount) {
+    Q_ASSERT(s_loopDepth == 0);
+
+    std::unique_lock lock(m_resizeMutex);
+
+    _stop();
+    _start(threadCount);
+}
+
+bool ThreadPool::tryResize(const size_t threadCount) {
+    Q_ASSERT(s_loopDepth == 0);
+
+    std::unique_lock lock(m_resizeMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return false;
+    }
+
+    _stop();
+    _start(threadCount);
+    return true;
+}
+
+void ThreadPool::_runJob(_Job &job, const size_t begin, const size_t end) {
+    _execute({&job, begin, end});
+
+    /* helping out with own tasks only - tasks of other callers would stall this one, e.g. mip rows of a loader
+     * inside of a frame. Also keeps nested loops inside of tasks from deadlocking */
+    size_t idleSpins = 0;
+    while (job.remaining.load(std::memory_order_acquire) != 0) {
+        if (_Task task{}; _tryPop(task, &job)) {
+            _execute(task);
+            idleSpins = 0;
+            continue;
+        }
+
+        if (++idleSpins < THREAD_CONSTANTS::CALLER_SPIN_COUNT) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        /* every push of a job task is followed by a finished one of the pushing thread - no wakeup is lost */
+        m_waitingCallers.fetch_add(1);
+        if (const uint32_t finished = m_finishedTasks.load(); job.remaining.load(std::memory_order_acquire) != 0) {
+            m_finishedTasks.wait(finished);
+        }
+        m_waitingCallers.fetch_sub(1);
+        idleSpins = 0;
+    }
+}
+
+void ThreadPool::_execute(_Task task) {
+    _Job &job = *task.job;
+
+    while (task.end - task.begin > job.grainSize) {
+        const size_t mid = task.begin + (task.end - task.begin) / 2;
+
+        _push({&job, mid, task.end});
+        task.end = mid;
+    }
+
+    job.invoke(job.context, task.begin, task.end);
+
+    /* last access to the job - its caller may return right after */
+    job.remaining.fetch_sub(task.end - task.begin, std::memory_order_acq_rel);
+
+    m_finishedTasks.fetch_add(1);
+    if (m_waitingCallers.load() > 0) {
+        m_finishedTasks.notify_all();
+    }
+}
+
+void ThreadPool::_push(const _Task &task) {
+    _TaskDeque &deque = *m_deques[s_workerPool == this ? s_dequeIdx : 0];
+
+    {
+        std::lock_guard lock(deque.mutex);
+        deque.tasks.push_back(task);
+        m_queuedTasks.fetch_add(1);
+    }
+
+    /* pairs with the predicate check of _workerLoop - either the worker sees the task or we see the worker asleep */
+    if (m_sleepingWorkers.load() > 0) {
+        {
+            std::lock_guard lock(m_sleepMutex);
+        }
+        m_sleepCondition.notify_one();
+    }
+}
+
+bool ThreadPool::_tryPop(_Task &task, const _Job *job) {
+    const size_t ownIdx = s_workerPool == this ? s_dequeIdx : 0;
+    const auto isTaken = [job](const _Task &candidate) {
+        return job == nullptr || candidate.job == job;
+    };
+
+    {
+        _TaskDeque &deque = *m_deques[ownIdx];
+        std::lock_guard lock(deque.mutex);
+
+        if (const auto it = std::find_if(deque.tasks.rbegin(), deque.tasks.rend(), isTaken);
+            it != deque.tasks.rend()) {
+            task = *it;
+            deque.tasks.erase(std::next(it).base());
+            m_queuedTasks.fetch_sub(1);
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < m_deques.size(); ++offset) {
+        _TaskDeque &deque = *m_deques[(ownIdx + offset) % m_deques.size()];
+        std::lock_guard lock(deque.mutex);
+
+        if (const auto it = std::find_if(deque.tasks.begin(), deque.tasks.end(), isTaken);
+            it != deque.tasks.end()) {
+            task = *it;
+            deque.tasks.erase(it);
+            m_queuedTasks.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::_workerLoop(const size_t dequeIdx) {
+    s_workerPool = this;
+    s_dequeIdx = dequeIdx;
+    /* every task belongs to a loop whose caller holds m_resizeMutex */
+    s_loopDepth = 1;
+
+    while (true) {
+        if (_Task task{}; _tryPop(task, nullptr)) {
+            _execute(task);
+            continue;
+        }
+
+        std::unique_lock lock(m_sleepMutex);
+
+        m_sleepingWorkers.fetch_add(1);
+        m_sleepCondition.wait(lock, [this] {
+            return m_isStopping || m_queuedTasks.load() > 0;
+        });
+        m_sleepingWorkers.fetch_sub(1);
+
+        /* resize waits for all the loops - no task is left behind */
+        if (m_isStopping) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::_start(const size_t threadCount) {
+    const size_t hardwareThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    const size_t count = std::clamp<size_t>(threadCount == 0 ? hardwareThreads : threadCount, 1,
+                                            THREAD_CONSTANTS::MAX_THREAD_COUNT);
+
+    m_isStopping = false;
+    m_threadCount.store(count, std::memory_order_relaxed);
+
+    m_deques.clear();
+    for (size_t idx = 0; idx < count; ++idx) {
+        m_deques.push_back(std::make_unique<_TaskDeque>());
+    }
+
+    /* the calling thread is the remaining one */
+    for (size_t idx = 1; idx < count; ++idx) {
+        m_workers.emplace_back(&ThreadPool::_workerLoop, this, idx);
+    }
+}
+
+void ThreadPool::_stop() {
+    {
+        std::lock_guard lock(m_sleepMutex);
+        m_isStopping = true;
+    }
+    m_sleepCondition.notify_all();
+
+    for (auto &worker: m_workers) {
+        worker.join();
+    }
+
+    m_workers.clear();
+}
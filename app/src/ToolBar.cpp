@@ -107,6 +107,13 @@ void ToolBar::setupToolBar(QToolBar *toolBar, DrawingWidget *drawingWidget) {
     m_loadNormalVectorsButton = pButton->getAction();
     m_toolBar->addWidget(pButton);
 
+    pButton = new TextButton(m_toolBar,
+                             "Generate normal vectors from a height map!",
+                             "Load height map",
+                             ":/icons/load_icon.png");
+    m_loadHeightMapButton = pButton->getAction();
+    m_toolBar->addWidget(pButton);
+
     pButton = new TextButton(m_toolBar,
                              "Enable usage of normal vectors in the program",
                              "Enable normal vectors",
@@ -115,6 +122,24 @@ void ToolBar::setupToolBar(QToolBar *toolBar, DrawingWidget *drawingWidget) {
     m_enableNormalVectorsButton->setCheckable(true);
     m_toolBar->addWidget(pButton);
 
+    pButton = new TextButton(m_toolBar,
+                             "Compute lighting once per vertex and interpolate it over triangles",
+                             "Per vertex lighting",
+                             ":/icons/vector_icon.png");
+    m_perVertexLightingButton = pButton->getAction();
+    m_perVertexLightingButton->setCheckable(true);
+    m_perVertexLightingButton->setChecked(LIGHTING_CONSTANTS::DEFAULT_PER_VERTEX_LIGHTING);
+    m_toolBar->addWidget(pButton);
+
+    pButton = new TextButton(m_toolBar,
+                             "Use per vertex lighting for frames rendered while interacting",
+                             "Per vertex preview",
+                             ":/icons/vector_icon.png");
+    m_perVertexPreviewButton = pButton->getAction();
+    m_perVertexPreviewButton->setCheckable(true);
+    m_perVertexPreviewButton->setChecked(LIGHTING_CONSTANTS::DEFAULT_PER_VERTEX_PREVIEW);
+    m_toolBar->addWidget(pButton);
+
     // Rotation section
     _addSeparator();
     _addToolbarLiteral("Rotations:");
@@ -150,6 +175,15 @@ void ToolBar::setupToolBar(QToolBar *toolBar, DrawingWidget *drawingWidget) {
     _addSeparator();
     _addToolbarLiteral("Lightning options:");
 
+    m_kaSlider = new DoubleSlider(Qt::Horizontal, m_toolBar,
+                                  SLIDER_CONSTANTS::KA::MIN,
+                                  SLIDER_CONSTANTS::KA::MAX,
+                                  SLIDER_CONSTANTS::KA::STEPS,
+                                  SLIDER_CONSTANTS::KA::DEFAULT_STEP,
+                                  "Ka coefficient",
+                                  "Ka coefficient for ambient light, scaled by baked occlusion");
+    m_toolBar->addWidget(m_kaSlider->getContainer());
+
     m_ksSlider = new DoubleSlider(Qt::Horizontal, m_toolBar,
                                   SLIDER_CONSTANTS::KS::MIN,
                                   SLIDER_CONSTANTS::KS::MAX,
@@ -186,6 +220,24 @@ void ToolBar::setupToolBar(QToolBar *toolBar, DrawingWidget *drawingWidget) {
                                                  "Position of lighting equation");
     m_toolBar->addWidget(m_lightningPositionSlider->getContainer());
 
+    m_lightCountSlider = new DoubleSlider(Qt::Horizontal, m_toolBar,
+                                          SLIDER_CONSTANTS::LIGHT_COUNT::MIN,
+                                          SLIDER_CONSTANTS::LIGHT_COUNT::MAX,
+                                          SLIDER_CONSTANTS::LIGHT_COUNT::STEPS,
+                                          SLIDER_CONSTANTS::LIGHT_COUNT::DEFAULT_STEP,
+                                          "Light count",
+                                          "Number of lights spread evenly around the spiral");
+    m_toolBar->addWidget(m_lightCountSlider->getContainer());
+
+    m_threadCountSlider = new DoubleSlider(Qt::Horizontal, m_toolBar,
+                                           SLIDER_CONSTANTS::THREAD_COUNT::MIN,
+                                           SLIDER_CONSTANTS::THREAD_COUNT::MAX,
+                                           SLIDER_CONSTANTS::THREAD_COUNT::STEPS,
+                                           SLIDER_CONSTANTS::THREAD_COUNT::DEFAULT_STEP,
+                                           "Worker threads",
+                                           "Threads used for rendering, 0 - one per hardware thread");
+    m_toolBar->addWidget(m_threadCountSlider->getContainer());
+
     pButton = new TextButton(m_toolBar,
                              "Stop movement of light source!",
                              "Stop light movement",
@@ -195,6 +247,15 @@ void ToolBar::setupToolBar(QToolBar *toolBar, DrawingWidget *drawingWidget) {
     m_stopLightMovementButton->setChecked(true);
     m_toolBar->addWidget(pButton);
 
+    pButton = new TextButton(m_toolBar,
+                             "Let the surface cast shadows from every light",
+                             "Enable shadows",
+                             ":/icons/vector_icon.png");
+    m_enableShadowsButton = pButton->getAction();
+    m_enableShadowsButton->setCheckable(true);
+    m_enableShadowsButton->setChecked(LIGHTING_CONSTANTS::DEFAULT_USE_SHADOWS);
+    m_toolBar->addWidget(pButton);
+
     pButton = new TextButton(m_toolBar,
                              "Change color of the plain!",
                              "Change color",
@@ -0,0 +1,185 @@
+//
+// Created by Jlisowskyy on 11/16/24.
+//
+
+/* internal includes */
+#include "../include/Rendering/TriangleBvh.h"
+
+/* external includes */
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+TriangleBvh::TriangleBvh(const MeshArr &triangles) {
+    m_triangles.reserve(triangles.size());
+    m_centroids.reserve(triangles.size());
+
+    for (const auto &triangle: triangles) {
+        const float3 &p0 = triangle[0].position;
+        const float3 &p1 = triangle[1].position;
+        const float3 &p2 = triangle[2].position;
+
+        m_triangles.push_back({p0, p1 - p0, p2 - p0});
+        m_centroids.push_back((p0 + p1 + p2) / 3.0f);
+    }
+
+    if (!m_triangles.empty()) {
+        m_nodes.reserve(2 * m_triangles.size() / MAX_LEAF_SIZE + 1);
+        _build(0, static_cast<uint32_t>(m_triangles.size()));
+    }
+
+    /* only needed while splitting */
+    m_centroids = {};
+}
+
+uint32_t TriangleBvh::_build(const uint32_t begin, const uint32_t end) {
+    const auto nodeIdx = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.push_back({});
+
+    float3 boundsMin(FLT_MAX, FLT_MAX, FLT_MAX);
+    float3 boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    float3 centroidMin = boundsMin;
+    float3 centroidMax = boundsMax;
+
+    for (uint32_t idx = begin; idx < end; ++idx) {
+        const _Triangle &triangle = m_triangles[idx];
+
+        for (const float3 &p: {triangle.v0, triangle.v0 + triangle.edge1, triangle.v0 + triangle.edge2}) {
+            boundsMin = min(boundsMin, p);
+            boundsMax = max(boundsMax, p);
+        }
+
+        centroidMin = min(centroidMin, m_centroids[idx]);
+        centroidMax = max(centroidMax, m_centroids[idx]);
+    }
+
+    m_nodes[nodeIdx].boundsMin = boundsMin;
+    m_nodes[nodeIdx].boundsMax = boundsMax;
+
+    const float3 extent = centroidMax - centroidMin;
+    const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    if (end - begin <= MAX_LEAF_SIZE || extent[axis] <= 0.0f) {
+        m_nodes[nodeIdx].first = begin;
+        m_nodes[nodeIdx].count = end - begin;
+        return nodeIdx;
+    }
+
+    /* median split along the longest centroid axis - triangles and centroids are reordered together */
+    const uint32_t mid = begin + (end - begin) / 2;
+
+    std::vector<uint32_t> order(end - begin);
+    std::iota(order.begin(), order.end(), begin);
+    std::nth_element(order.begin(), order.begin() + (mid - begin), order.end(),
+                     [this, axis](const uint32_t a, const uint32_t b) {
+                         return m_centroids[a][axis] < m_centroids[b][axis];
+                     });
+
+    std::vector<_Triangle> sortedTriangles{};
+    std::vector<float3> sortedCentroids{};
+    sortedTriangles.reserve(order.size());
+    sortedCentroids.reserve(order.size());
+
+    for (const uint32_t idx: order) {
+        sortedTriangles.push_back(m_triangles[idx]);
+        sortedCentroids.push_back(m_centroids[idx]);
+    }
+
+    std::copy(sortedTriangles.begin(), sortedTriangles.end(), m_triangles.begin() + begin);
+    std::copy(sortedCentroids.begin(), sortedCentroids.end(), m_centroids.begin() + begin);
+
+    /* left child directly follows its parent */
+    _build(begin, mid);
+    const uint32_t rightIdx = _build(mid, end);
+
+    m_nodes[nodeIdx].first = rightIdx;
+    m_nodes[nodeIdx].count = 0;
+
+    return nodeIdx;
+}
+
+bool TriangleBvh::isOccluded(const float3 &origin, const float3 &direction, const float maxDistance) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    const float3 invDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+    std::array<uint32_t, MAX_DEPTH> stack{};
+    size_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const uint32_t nodeIdx = stack[--stackSize];
+        const _Node &node = m_nodes[nodeIdx];
+
+        if (!_isBoxHit(node, origin, invDirection, maxDistance)) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (uint32_t idx = node.first; idx < node.first + node.count; ++idx) {
+                if (_isTriangleHit(m_triangles[idx], origin, direction, maxDistance)) {
+                    return true;
+                }
+            }
+
+            continue;
+        }
+
+        Q_ASSERT(stackSize + 2 <= MAX_DEPTH);
+        stack[stackSize++] = node.first;
+        stack[stackSize++] = nodeIdx + 1;
+    }
+
+    return false;
+}
+
+bool TriangleBvh::_isBoxHit(const _Node &node, const float3 &origin, const float3 &invDirection,
+                            const float maxDistance) {
+    float tMin = 0.0f;
+    float tMax = maxDistance;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        const float t0 = (node.boundsMin[axis] - origin[axis]) * invDirection[axis];
+        const float t1 = (node.boundsMax[axis] - origin[axis]) * invDirection[axis];
+
+        tMin = std::max(tMin, std::min(t0, t1));
+        tMax = std::min(tMax, std::max(t0, t1));
+    }
+
+    return tMin <= tMax;
+}
+
+bool TriangleBvh::_isTriangleHit(const _Triangle &triangle, const float3 &origin, const float3 &direction,
+                                 const float maxDistance) {
+    static constexpr float EPSILON = 1e-7f;
+
+    const float3 p = cross(direction, triangle.edge2);
+    const float det = dot(triangle.edge1, p);
+
+    /* ray parallel to the triangle plane */
+    if (std::abs(det) < EPSILON) {
+        return false;
+    }
+
+    const float invDet = 1.0f / det;
+    const float3 s = origin - triangle.v0;
+    const float u = dot(s, p) * invDet;
+
+    if (u < 0.0f || u > 1.0f) {
+        return false;
+    }
+
+    const float3 q = cross(s, triangle.edge1);
+    const float v = dot(direction, q) * invDet;
+
+    if (v < 0.0f || u + v > 1.0f) {
+        return false;
+    }
+
+    const float t = dot(triangle.edge2, q) * invDet;
+    return t > 0.0f && t <= maxDistance;
+}
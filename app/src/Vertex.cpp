@@ -7,21 +7,19 @@
 #include "../include/Rendering/Mesh.h"
 #include "../include/ManagingObjects/StateMgr.h"
 
-Vertex::Vertex(const QVector3D &p,
-               const QVector3D &pu,
-               const QVector3D &pv,
-               const QVector3D &n,
+Vertex::Vertex(const float3 &p,
+               const float3 &t,
+               const float3 &b,
+               const float3 &n,
                const float u,
                const float v,
                const float alpha,
                const float beta,
                const float delta) : position(p),
-                                    puVector(pu),
-                                    pvVector(pv),
+                                    tangent(t),
+                                    bitangent(b),
                                     normal(n),
                                     rotatedPosition(p),
-                                    rotatedPuVector(pu),
-                                    rotatedPvVector(pv),
                                     rotatedNormal(n),
                                     u(u),
                                     v(v) {
@@ -30,14 +28,10 @@ Vertex::Vertex(const QVector3D &p,
 
 void Vertex::resetRotation() {
     rotatedPosition = position;
-    rotatedPuVector = puVector;
     rotatedNormal = normal;
-    rotatedPvVector = pvVector;
 }
 
 void Vertex::rotate(const float alpha, const float beta, const float delta) {
     Mesh::rotate(rotatedPosition, alpha, beta, delta);
-    Mesh::rotate(rotatedPuVector, alpha, beta, delta);
-    Mesh::rotate(rotatedPvVector, alpha, beta, delta);
     Mesh::rotate(rotatedNormal, alpha, beta, delta);
 }
@@ -0,0 +1,259 @@
+//
+// Created by Jlisowskyy on 11/14/24.
+//
+
+/* internal includes */
+#include "../include/Rendering/VirtualTexture.h"
+
+/* external includes */
+#include <QDebug>
+#include <QImage>
+#include <QImageReader>
+#include <QRect>
+#include <QtConcurrent>
+#include <algorithm>
+
+VirtualTexture::VirtualTexture(const QString &path, const QSize &size) : m_path(path) {
+    Q_ASSERT(size.width() > 0 && size.height() > 0);
+
+    /* virtual mip chain down to the level covered by a single tile */
+    for (int32_t levelIdx = 0;; ++levelIdx) {
+        const int32_t scale = 1 << levelIdx;
+        const int32_t width = std::max(1, (size.width() + scale - 1) / scale);
+        const int32_t height = std::max(1, (size.height() + scale - 1) / scale);
+        const int32_t tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+        const int32_t tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+        m_levels.push_back({
+            width, height, tilesX, tilesY,
+            static_cast<float>(width - 1), static_cast<float>(height - 1),
+            std::make_unique<_PageEntry[]>(static_cast<size_t>(tilesX) * tilesY)
+        });
+
+        if (tilesX == 1 && tilesY == 1) {
+            break;
+        }
+    }
+
+    /* coarsest tile is the final fallback - it is never evicted */
+    const _TileKey topKey{static_cast<int32_t>(m_levels.size() - 1), 0, 0};
+    auto topTile = _decodeTile(topKey);
+
+    if (!topTile) {
+        qWarning() << "Failed to decode virtual texture:" << path;
+        m_levels.clear();
+        return;
+    }
+
+    _pageAt(topKey).tile.store(topTile.get(), std::memory_order_release);
+    _pageAt(topKey).isLoading = true;
+    m_residentTiles.emplace_back(topKey, std::move(topTile));
+}
+
+VirtualTexture::~VirtualTexture() {
+    m_isShuttingDown.store(true, std::memory_order_relaxed);
+
+    for (auto &load: m_pendingLoads) {
+        load.waitForFinished();
+    }
+}
+
+float VirtualTexture::computeLod(const UvGradient &gradient) const {
+    return TextureImage::computeTexelLod(gradient, m_levels.front().xScale, m_levels.front().yScale);
+}
+
+QRgb VirtualTexture::sample(const float u, const float v, const float lod) const {
+    const auto topLevel = static_cast<int32_t>(m_levels.size() - 1);
+    int32_t levelIdx = lod > 0.0f ? std::min(static_cast<int32_t>(lod + 0.5f), topLevel) : 0;
+
+    /* terminates at the latest on the always resident top level */
+    for (;; ++levelIdx) {
+        const _Level &level = m_levels[levelIdx];
+        const float fx = TexelAddressing::clampCoord(v * level.xScale, level.xScale);
+        const float fy = TexelAddressing::clampCoord((1.0f - u) * level.yScale, level.yScale);
+        const auto x = static_cast<int32_t>(fx);
+        const auto y = static_cast<int32_t>(fy);
+        const int32_t tileX = x / TILE_SIZE;
+        const int32_t tileY = y / TILE_SIZE;
+
+        _PageEntry &page = _pageAt({levelIdx, tileX, tileY});
+        const _Tile *tile = page.tile.load(std::memory_order_acquire);
+
+        if (!tile) {
+            if (!page.isRequested.load(std::memory_order_relaxed)) {
+                page.isRequested.store(true, std::memory_order_relaxed);
+            }
+
+            continue;
+        }
+
+        if (page.lastUsedFrame.load(std::memory_order_relaxed) != m_frame) {
+            page.lastUsedFrame.store(m_frame, std::memory_order_relaxed);
+        }
+
+        /* border texels make x + 1 and y + 1 always valid inside the tile */
+        const int32_t localX = x - tileX * TILE_SIZE;
+        const int32_t localY = y - tileY * TILE_SIZE;
+        const float wx = fx - static_cast<float>(x);
+        const float wy = fy - static_cast<float>(y);
+
+        return TextureImage::blendBilinear(
+            tile->texelAt(localX, localY), tile->texelAt(localX + 1, localY),
+            tile->texelAt(localX, localY + 1), tile->texelAt(localX + 1, localY + 1),
+            wx, wy
+        );
+    }
+}
+
+void VirtualTexture::update() {
+    ++m_frame;
+
+    _publishTiles();
+    _evictTiles();
+    _requestTiles();
+}
+
+std::unique_ptr<VirtualTexture::_Tile> VirtualTexture::_decodeTile(const _TileKey &key) const {
+    const _Level &level = m_levels[key.level];
+    const _Level &base = m_levels.front();
+
+    const int32_t x0 = key.tileX * TILE_SIZE;
+    const int32_t y0 = key.tileY * TILE_SIZE;
+    const int32_t width = std::min(TILE_SIZE, level.width - x0);
+    const int32_t height = std::min(TILE_SIZE, level.height - y0);
+
+    /* tile with its border, clamped to the level */
+    const int32_t regionX0 = std::max(0, x0 - 1);
+    const int32_t regionY0 = std::max(0, y0 - 1);
+    const int32_t regionX1 = std::min(level.width, x0 + width + 1);
+    const int32_t regionY1 = std::min(level.height, y0 + height + 1);
+
+    /* only the clipped region is decoded, downscaled straight to the level resolution */
+    const int32_t shift = key.level;
+    const QRect sourceRect = QRect(regionX0 << shift, regionY0 << shift, (regionX1 - regionX0) << shift,
+                                   (regionY1 - regionY0) << shift).intersected(
+        QRect(0, 0, base.width, base.height));
+
+    QImageReader reader(m_path);
+    reader.setClipRect(sourceRect);
+    reader.setScaledSize(QSize(regionX1 - regionX0, regionY1 - regionY0));
+
+    const QImage image = reader.read().convertToFormat(QImage::Format_ARGB32);
+    if (image.isNull()) {
+        qWarning() << "Failed to decode virtual texture tile:" << reader.errorString();
+        return nullptr;
+    }
+
+    auto tile = std::make_unique<_Tile>();
+    tile->stride = width + 2;
+    tile->texels.resize(static_cast<size_t>(width + 2) * (height + 2));
+
+    /* border outside of the level replicates the edge */
+    for (int32_t y = -1; y <= height; ++y) {
+        const int32_t srcY = std::clamp(y0 + y, 0, level.height - 1) - regionY0;
+        const auto *row = reinterpret_cast<const QRgb *>(image.constScanLine(std::min(srcY, image.height() - 1)));
+
+        for (int32_t x = -1; x <= width; ++x) {
+            const int32_t srcX = std::clamp(x0 + x, 0, level.width - 1) - regionX0;
+            tile->texels[static_cast<size_t>(y + 1) * tile->stride + x + 1] = row[std::min(srcX, image.width() - 1)];
+        }
+    }
+
+    return tile;
+}
+
+void VirtualTexture::_publishTiles() {
+    std::vector<std::pair<_TileKey, std::unique_ptr<_Tile> > > completed{};
+    {
+        std::lock_guard lock(m_completedMutex);
+        completed.swap(m_completedTiles);
+    }
+
+    for (auto &[key, tile]: completed) {
+        _PageEntry &page = _pageAt(key);
+
+        /* failed tiles stay marked as loading - they are never retried, coarser levels cover them */
+        if (!tile) {
+            continue;
+        }
+
+        page.isLoading = false;
+        page.lastUsedFrame.store(m_frame, std::memory_order_relaxed);
+        page.tile.store(tile.get(), std::memory_order_release);
+        m_residentTiles.emplace_back(key, std::move(tile));
+    }
+
+    m_pendingLoads.erase(std::remove_if(m_pendingLoads.begin(), m_pendingLoads.end(), [](const QFuture<void> &load) {
+        return load.isFinished();
+    }), m_pendingLoads.end());
+}
+
+void VirtualTexture::_evictTiles() {
+    if (m_residentTiles.size() <= RESOURCE_CONSTANTS::VIRTUAL_TEXTURE_MAX_TILES) {
+        return;
+    }
+
+    const auto topLevel = static_cast<int32_t>(m_levels.size() - 1);
+    const auto lastUsed = [this, topLevel](const std::pair<_TileKey, std::unique_ptr<_Tile> > &entry) {
+        /* top tile sorts last, so it is never picked */
+        return entry.first.level == topLevel
+                   ? UINT32_MAX
+                   : _pageAt(entry.first).lastUsedFrame.load(std::memory_order_relaxed);
+    };
+
+    const size_t evictCount = m_residentTiles.size() - RESOURCE_CONSTANTS::VIRTUAL_TEXTURE_MAX_TILES;
+    std::nth_element(m_residentTiles.begin(), m_residentTiles.begin() + static_cast<ptrdiff_t>(evictCount),
+                     m_residentTiles.end(), [&lastUsed](const auto &a, const auto &b) {
+                         return lastUsed(a) < lastUsed(b);
+                     });
+
+    /* no sampling is running - unpublished tiles can be released right away */
+    for (size_t idx = 0; idx < evictCount; ++idx) {
+        _PageEntry &page = _pageAt(m_residentTiles[idx].first);
+        page.tile.store(nullptr, std::memory_order_relaxed);
+        page.isRequested.store(false, std::memory_order_relaxed);
+    }
+
+    m_residentTiles.erase(m_residentTiles.begin(), m_residentTiles.begin() + static_cast<ptrdiff_t>(evictCount));
+}
+
+void VirtualTexture::_requestTiles() {
+    /* coarse levels first - they replace the fallback for the largest screen area */
+    for (auto levelIdx = static_cast<int32_t>(m_levels.size() - 1); levelIdx >= 0; --levelIdx) {
+        const _Level &level = m_levels[levelIdx];
+
+        for (int32_t tileY = 0; tileY < level.tilesY; ++tileY) {
+            for (int32_t tileX = 0; tileX < level.tilesX; ++tileX) {
+                if (m_pendingLoads.size() >= RESOURCE_CONSTANTS::VIRTUAL_TEXTURE_MAX_PENDING_LOADS) {
+                    return;
+                }
+
+                const _TileKey key{levelIdx, tileX, tileY};
+                _PageEntry &page = _pageAt(key);
+
+                if (page.isLoading || !page.isRequested.load(std::memory_order_relaxed) ||
+                    page.tile.load(std::memory_order_relaxed)) {
+                    continue;
+                }
+
+                page.isLoading = true;
+                page.isRequested.store(false, std::memory_order_relaxed);
+
+                m_pendingLoads.push_back(QtConcurrent::run([this, key] {
+                    std::unique_ptr<_Tile> tile{};
+
+                    if (!m_isShuttingDown.load(std::memory_order_relaxed)) {
+                        tile = _decodeTile(key);
+                    }
+
+                    {
+                        std::lock_guard lock(m_completedMutex);
+                        m_completedTiles.emplace_back(key, std::move(tile));
+                    }
+
+                    emit tilesArrived();
+                }));
+            }
+        }
+    }
+}